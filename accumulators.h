@@ -0,0 +1,54 @@
+#ifndef PARALLEL_ACCUMULATORS_H
+#define PARALLEL_ACCUMULATORS_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef __cpp_lib_hardware_interference_size
+    using std::hardware_constructive_interference_size;
+    using std::hardware_destructive_interference_size;
+#else
+    constexpr std::size_t hardware_constructive_interference_size = 64;
+    constexpr std::size_t hardware_destructive_interference_size = 64;
+#endif
+
+// One value per cache line. The single place for the alignas(64) idea that
+// used to be duplicated as partialSumT in main.cpp and two local
+// reduction_partial_result_t structs in reduction.cpp — kernels written
+// without it (integrateArr's accum) ship false sharing.
+template <class T>
+struct padded_accumulator {
+    alignas(hardware_destructive_interference_size) T value;
+};
+
+// Aligned array of one padded_accumulator per thread, zero-initialized.
+// Replaces the raw aligned_alloc + memset pattern.
+template <class T>
+class per_thread_array {
+    padded_accumulator<T> *data_;
+    unsigned size_;
+
+public:
+    explicit per_thread_array(unsigned T_) : size_(T_) {
+        data_ = static_cast<padded_accumulator<T> *>(
+                std::aligned_alloc(hardware_destructive_interference_size,
+                                   T_ * sizeof(padded_accumulator<T>)));
+        // Value-initialization instead of copying a zero so non-copyable
+        // slot types (std::atomic) work too.
+        for (unsigned t = 0; t < T_; ++t)
+            new(&data_[t]) padded_accumulator<T>();
+    }
+
+    ~per_thread_array() { std::free(data_); }
+
+    per_thread_array(const per_thread_array &) = delete;
+    per_thread_array &operator=(const per_thread_array &) = delete;
+
+    T &operator[](unsigned t) { return data_[t].value; }
+    const T &operator[](unsigned t) const { return data_[t].value; }
+
+    unsigned size() const { return size_; }
+};
+
+#endif //PARALLEL_ACCUMULATORS_H
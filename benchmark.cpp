@@ -0,0 +1,329 @@
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <omp.h>
+#include "benchmark.h"
+#include "threads.h"
+
+namespace {
+
+struct benchmark_entry {
+    std::string name;
+    std::function<ExperimentResult()> run;
+};
+
+std::vector<benchmark_entry> &registry() {
+    static std::vector<benchmark_entry> entries;
+    return entries;
+}
+
+struct cell_stats {
+    double result;
+    double min;
+    double median;
+    double stddev;
+};
+
+// Pre-spawns both thread layers at the current T so no timed repetition pays
+// worker creation: an empty pool dispatch grows our pool, an empty parallel
+// region grows the OpenMP one.
+void warm_pool() {
+    unsigned T = get_num_threads();
+    run_on_pool(T, [](unsigned) {});
+#pragma omp parallel
+    {}
+}
+
+cell_stats measure_cell(const benchmark_entry &e, unsigned reps, unsigned warmup) {
+    std::vector<double> times(reps);
+    double result = 0;
+
+    warm_pool();
+    // Discarded repetitions: they fault in the experiment's buffers, warm the
+    // predictors and caches, and absorb any one-off lazy initialization.
+    for (unsigned r = 0; r < warmup; ++r)
+        e.run();
+
+    for (unsigned r = 0; r < reps; ++r) {
+        ExperimentResult R = e.run();
+        times[r] = R.time;
+        result = R.result;
+    }
+
+    std::sort(times.begin(), times.end());
+    double median = (reps % 2) ? times[reps / 2]
+                               : (times[reps / 2 - 1] + times[reps / 2]) / 2;
+    double mean = 0;
+    for (double t: times)
+        mean += t;
+    mean /= reps;
+    double var = 0;
+    for (double t: times)
+        var += (t - mean) * (t - mean);
+    double stddev = (reps > 1) ? std::sqrt(var / (reps - 1)) : 0;
+
+    return {result, times[0], median, stddev};
+}
+
+}
+
+void register_benchmark(const std::string &name, std::function<ExperimentResult()> run) {
+    registry().push_back({name, std::move(run)});
+}
+
+static std::function<void(std::size_t)> &problem_size_hook() {
+    static std::function<void(std::size_t)> hook;
+    return hook;
+}
+
+void set_problem_size_hook(std::function<void(std::size_t)> hook) {
+    problem_size_hook() = std::move(hook);
+}
+
+void run_size_sweep(output_format fmt, unsigned reps, std::size_t min_n, std::size_t max_n,
+                    unsigned warmup) {
+    // n *= 4 never advances from 0, so a zero minimum would sweep forever.
+    if (min_n == 0) {
+        printf("sweep minimum must be positive\n");
+        return;
+    }
+    if (fmt == output_format::csv)
+        printf("kernel,n,result,min,median,stddev\n");
+    bool first = true;
+    if (fmt == output_format::json)
+        printf("[\n");
+
+    for (const auto &e: registry()) {
+        if (fmt == output_format::table) {
+            printf("%s\n", e.name.c_str());
+            printf("%12s\t %10s\t %10s\t %10s\t %10s\n",
+                   "n", "Result", "Min", "Median", "Stddev");
+        }
+
+        for (std::size_t n = min_n; n <= max_n; n *= 4) {
+            problem_size_hook()(n);
+            cell_stats s = measure_cell(e, reps, warmup);
+
+            switch (fmt) {
+                case output_format::table:
+                    printf("%12zu\t %10g\t %10g\t %10g\t %10g\n",
+                           n, s.result, s.min, s.median, s.stddev);
+                    break;
+                case output_format::csv:
+                    printf("%s,%zu,%g,%g,%g,%g\n",
+                           e.name.c_str(), n, s.result, s.min, s.median, s.stddev);
+                    break;
+                case output_format::json:
+                    printf("%s  {\"kernel\": \"%s\", \"n\": %zu, \"result\": %g, "
+                           "\"min\": %g, \"median\": %g, \"stddev\": %g}",
+                           first ? "" : ",\n", e.name.c_str(), n,
+                           s.result, s.min, s.median, s.stddev);
+                    first = false;
+                    break;
+            }
+        }
+
+        if (fmt == output_format::table)
+            printf("\n");
+    }
+
+    if (fmt == output_format::json)
+        printf("\n]\n");
+}
+
+void run_benchmarks(output_format fmt, unsigned reps, unsigned warmup) {
+    bool first = true;
+    if (fmt == output_format::json)
+        printf("[\n");
+
+    if (fmt == output_format::csv)
+        printf("kernel,threads,result,min,median,stddev,speedup\n");
+
+    for (const auto &e: registry()) {
+        if (fmt == output_format::table) {
+            printf("%s\n", e.name.c_str());
+            printf("%4s\t %10s\t %10s\t %10s\t %10s\t %10s\n",
+                   "T", "Result", "Min", "Median", "Stddev", "Speedup");
+        }
+
+        double T1_median = 0;
+        for (int T = 1; T <= omp_get_num_procs(); ++T) {
+            set_num_threads(T);
+            cell_stats s = measure_cell(e, reps, warmup);
+            if (T == 1)
+                T1_median = s.median;
+            double speedup = T1_median / s.median;
+
+            switch (fmt) {
+                case output_format::table:
+                    printf("%4d\t %10g\t %10g\t %10g\t %10g\t %10g\n",
+                           T, s.result, s.min, s.median, s.stddev, speedup);
+                    break;
+                case output_format::csv:
+                    printf("%s,%d,%g,%g,%g,%g,%g\n",
+                           e.name.c_str(), T, s.result, s.min, s.median, s.stddev, speedup);
+                    break;
+                case output_format::json:
+                    printf("%s  {\"kernel\": \"%s\", \"threads\": %d, \"result\": %g, "
+                           "\"min\": %g, \"median\": %g, \"stddev\": %g, \"speedup\": %g}",
+                           first ? "" : ",\n", e.name.c_str(), T,
+                           s.result, s.min, s.median, s.stddev, speedup);
+                    first = false;
+                    break;
+            }
+        }
+
+        if (fmt == output_format::table)
+            printf("\n");
+    }
+
+    if (fmt == output_format::json)
+        printf("\n]\n");
+}
+
+void run_comparison(const std::vector<std::string> &names, unsigned reps, unsigned warmup) {
+    auto find = [](const std::string &name) -> const benchmark_entry * {
+        for (const auto &e: registry())
+            if (e.name == name)
+                return &e;
+        printf("unknown kernel: %s\n", name.c_str());
+        return nullptr;
+    };
+    if (names.empty())
+        return;
+
+    const benchmark_entry *ref = find(names[0]);
+    if (!ref)
+        return;
+
+    set_num_threads(1);
+    cell_stats base = measure_cell(*ref, reps, warmup);
+    printf("serial baseline: %s, T=1, median %g\n\n", ref->name.c_str(), base.median);
+
+    struct row {
+        const benchmark_entry *e;
+        cell_stats s;
+    };
+    std::vector<row> rows;
+
+    unsigned P = (unsigned) omp_get_num_procs();
+    set_num_threads(P);
+    for (const auto &name: names)
+        if (const benchmark_entry *e = find(name))
+            rows.push_back({e, measure_cell(*e, reps, warmup)});
+
+    std::sort(rows.begin(), rows.end(),
+              [](const row &a, const row &b) { return a.s.median < b.s.median; });
+
+    printf("%4s\t %-24s\t %10s\t %10s\t %10s\t %10s\n",
+           "rank", "kernel", "Result", "Median", "Stddev", "Speedup");
+    for (std::size_t i = 0; i < rows.size(); ++i)
+        printf("%4zu\t %-24s\t %10g\t %10g\t %10g\t %10g\n",
+               i + 1, rows[i].e->name.c_str(), rows[i].s.result,
+               rows[i].s.median, rows[i].s.stddev, base.median / rows[i].s.median);
+}
+
+void record_baseline(const char *path, unsigned reps, unsigned warmup) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return;
+    }
+
+    fprintf(out, "[\n");
+    bool first = true;
+    for (const auto &e: registry())
+        for (int T = 1; T <= omp_get_num_procs(); ++T) {
+            set_num_threads(T);
+            cell_stats s = measure_cell(e, reps, warmup);
+            fprintf(out, "%s  {\"kernel\": \"%s\", \"threads\": %d, \"median\": %.9g, "
+                         "\"tolerance\": 1.15}",
+                    first ? "" : ",\n", e.name.c_str(), T, s.median);
+            first = false;
+        }
+    fprintf(out, "\n]\n");
+    fclose(out);
+    printf("recorded baseline to %s\n", path);
+}
+
+int check_baseline(const char *path, unsigned reps, unsigned warmup) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        perror(path);
+        return 1;
+    }
+
+    int regressions = 0;
+    char line[512];
+    // One object per line, exactly as record_baseline writes them; sscanf is
+    // all the JSON parsing this format needs.
+    while (fgets(line, sizeof(line), in)) {
+        char name[128];
+        int T;
+        double base, tol;
+        if (sscanf(line, " %*[,{]\"kernel\": \"%127[^\"]\", \"threads\": %d, "
+                         "\"median\": %lg, \"tolerance\": %lg",
+                   name, &T, &base, &tol) != 4 &&
+            sscanf(line, " {\"kernel\": \"%127[^\"]\", \"threads\": %d, "
+                         "\"median\": %lg, \"tolerance\": %lg",
+                   name, &T, &base, &tol) != 4)
+            continue;
+
+        const benchmark_entry *entry = nullptr;
+        for (const auto &e: registry())
+            if (e.name == name)
+                entry = &e;
+        if (!entry) {
+            printf("MISSING  %s (in baseline, not registered)\n", name);
+            ++regressions;
+            continue;
+        }
+        if (T > omp_get_num_procs())
+            continue;
+
+        set_num_threads((unsigned) T);
+        cell_stats s = measure_cell(*entry, reps, warmup);
+        bool bad = s.median > base * tol;
+        printf("%s  %s T=%d: median %g vs baseline %g (x%.2f allowed %.2f)\n",
+               bad ? "REGRESSED" : "ok", name, T, s.median, base,
+               base > 0 ? s.median / base : 0.0, tol);
+        if (bad)
+            ++regressions;
+    }
+    fclose(in);
+
+    if (regressions)
+        printf("%d cell(s) regressed beyond tolerance\n", regressions);
+    return regressions;
+}
+
+void parse_benchmark_args(int argc, char **argv, output_format &fmt, unsigned &reps,
+                          unsigned &warmup) {
+    fmt = output_format::table;
+    reps = 5;
+    warmup = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--format=csv"))
+            fmt = output_format::csv;
+        else if (!strcmp(argv[i], "--format=json"))
+            fmt = output_format::json;
+        else if (!strcmp(argv[i], "--format=table"))
+            fmt = output_format::table;
+        else if (!strncmp(argv[i], "--reps=", 7))
+            reps = (unsigned) atoi(argv[i] + 7);
+        else if (!strncmp(argv[i], "--warmup=", 9))
+            warmup = (unsigned) atoi(argv[i] + 9);
+        else if (!strcmp(argv[i], "--pin"))
+            pin_threads(true);
+    }
+
+    // measure_cell indexes times[reps / 2 - 1] and times[0]; zero repetitions
+    // would read an empty vector.
+    if (reps == 0)
+        reps = 1;
+}
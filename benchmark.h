@@ -0,0 +1,58 @@
+#ifndef PARALLEL_BENCHMARK_H
+#define PARALLEL_BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+struct ExperimentResult {
+    double result;
+    double time;
+};
+
+enum class output_format { table, csv, json };
+
+// Registers a kernel under a name. run() executes one repetition at the
+// current get_num_threads() setting and reports {result, seconds}.
+void register_benchmark(const std::string &name, std::function<ExperimentResult()> run);
+
+// Runs every registered kernel at T = 1..omp_get_num_procs() with reps
+// repetitions per cell and prints min/median/stddev per (kernel, T) plus the
+// speedup against the kernel's single-thread median. Before each cell the
+// pool is pre-spawned at the new T and warmup repetitions run untimed, so
+// thread creation, first-touch page faults and cold predictors land in the
+// discarded runs instead of biasing the low-T baseline.
+void run_benchmarks(output_format fmt, unsigned reps, unsigned warmup = 1);
+
+// Understands --format=table|csv|json, --reps=N and --warmup=K (repetitions
+// discarded per cell). Defaults: table, 5, 1.
+void parse_benchmark_args(int argc, char **argv, output_format &fmt, unsigned &reps,
+                          unsigned &warmup);
+
+// Comparison mode: measures the named kernels in one process — same warmed
+// pool, same machine state — at the full thread count, against one shared
+// serial baseline (the first name, measured once at T=1), and prints a
+// ranking table sorted by median. Cross-variant ratios from separate runs
+// were apples-to-oranges because every run re-measured its own baseline.
+void run_comparison(const std::vector<std::string> &names, unsigned reps, unsigned warmup);
+
+// Perf gate. record_baseline measures every registered kernel at every T and
+// writes (kernel, threads, median seconds, tolerance) as JSON; the tolerance
+// field is a per-cell ratio (default 1.15) meant to be hand-tuned per kernel
+// in the recorded file. check_baseline reruns each recorded cell and reports
+// every median exceeding baseline * tolerance; it returns the number of
+// regressed cells, so main can exit nonzero and CI fails the release.
+void record_baseline(const char *path, unsigned reps, unsigned warmup);
+int check_baseline(const char *path, unsigned reps, unsigned warmup);
+
+// Installs the callback the size sweep uses to rescale the workload (grid
+// steps, buffer lengths) before each measured size.
+void set_problem_size_hook(std::function<void(std::size_t)> hook);
+
+// Sweep mode: measures every registered kernel across a log-spaced size
+// range (x4 per step) at the current thread count, so the n where a variant
+// falls out of L2, L3 or DRAM bandwidth is visible without recompiling.
+void run_size_sweep(output_format fmt, unsigned reps, std::size_t min_n, std::size_t max_n,
+                    unsigned warmup = 1);
+
+#endif //PARALLEL_BENCHMARK_H
@@ -0,0 +1,104 @@
+#ifndef PARALLEL_INSTRUMENT_H
+#define PARALLEL_INSTRUMENT_H
+
+// Opt-in per-thread phase timing inside the parallel kernels. Configure with
+// -DPROFILE_PHASES=ON (CMake option) to enable; when disabled every macro
+// expands to nothing and the inline functions are empty, so instrumented
+// kernels carry zero overhead.
+//
+// Usage inside a worker:
+//   PROF_START(t);                  // open a phase on worker t
+//   ... compute ...
+//   PROF_PHASE(t, prof_compute);    // charge the open phase, reopen
+//   bar.arrive_and_wait();
+//   PROF_PHASE(t, prof_sync);
+//
+// The experiment driver brackets the kernel with prof_reset(T) and
+// prof_report(T); the report shows cycles per phase per worker and the
+// compute imbalance (slowest worker over mean).
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include "accumulators.h"
+
+enum prof_phase { prof_compute, prof_sync, prof_combine, prof_phase_count };
+
+#ifdef PROFILE_PHASES
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+inline uint64_t prof_now() { return __rdtsc(); }
+#else
+#include <chrono>
+inline uint64_t prof_now() {
+    return (uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+}
+#endif
+
+constexpr unsigned prof_max_threads = 256;
+
+struct prof_slot {
+    uint64_t begin;
+    uint64_t phase[prof_phase_count];
+};
+
+inline padded_accumulator<prof_slot> prof_slots[prof_max_threads];
+
+inline void prof_reset(unsigned T) {
+    for (unsigned t = 0; t < T && t < prof_max_threads; ++t)
+        std::memset(&prof_slots[t].value, 0, sizeof(prof_slot));
+}
+
+inline void prof_report(unsigned T) {
+    static const char *names[prof_phase_count] = {"compute", "sync", "combine"};
+    uint64_t max_compute = 0, sum_compute = 0;
+
+    printf("%4s", "t");
+    for (int p = 0; p < prof_phase_count; ++p)
+        printf("\t %12s", names[p]);
+    printf("\n");
+
+    for (unsigned t = 0; t < T && t < prof_max_threads; ++t) {
+        printf("%4u", t);
+        for (int p = 0; p < prof_phase_count; ++p)
+            printf("\t %12llu", (unsigned long long) prof_slots[t].value.phase[p]);
+        printf("\n");
+        uint64_t c = prof_slots[t].value.phase[prof_compute];
+        sum_compute += c;
+        if (c > max_compute)
+            max_compute = c;
+    }
+    if (sum_compute)
+        printf("imbalance (max/mean compute): %g\n",
+               (double) max_compute * T / (double) sum_compute);
+}
+
+// Both macros bounds-check t like prof_reset/prof_report do: on a machine
+// with more than prof_max_threads hardware threads the excess workers simply
+// go unprofiled instead of writing past the slot array.
+#define PROF_START(t)                                                        \
+    do {                                                                     \
+        if ((t) < prof_max_threads)                                          \
+            prof_slots[t].value.begin = prof_now();                          \
+    } while (0)
+#define PROF_PHASE(t, p)                                                     \
+    do {                                                                     \
+        if ((t) >= prof_max_threads)                                         \
+            break;                                                           \
+        uint64_t prof_now_ = prof_now();                                     \
+        prof_slots[t].value.phase[p] += prof_now_ - prof_slots[t].value.begin; \
+        prof_slots[t].value.begin = prof_now_;                               \
+    } while (0)
+
+#else
+
+inline void prof_reset(unsigned) {}
+inline void prof_report(unsigned) {}
+
+#define PROF_START(t) ((void) 0)
+#define PROF_PHASE(t, p) ((void) 0)
+
+#endif //PROFILE_PHASES
+
+#endif //PARALLEL_INSTRUMENT_H
@@ -4,10 +4,25 @@
 #include <iostream>
 #include <omp.h>
 #include <cstring>
+#include <cstdlib>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+#include "threads.h"
+#include "task_scheduler.h"
+#include "accumulators.h"
+#include "instrument.h"
+#include "timer.h"
+#include "benchmark.h"
 #include "reduction.cpp"
-
-#define STEPS 100000000
-#define CACHE_LINE 64u
+#include "par.h"
+#include "stream_reduce.h"
+
+// Runtime problem sizes; the defaults match the old compile-time constants.
+// --steps=N / --length=N override them, and the --sweep mode rescales both
+// per measurement, so production-sized runs no longer require a recompile.
+static size_t STEPS = 100000000;
+static size_t ARRAY_LENGTH = 100000;
 #define A -1
 #define B 1
 #define MIN 1
@@ -18,13 +33,6 @@ typedef double (*f_t)(double);
 typedef double (*E_t)(double, double, f_t);
 typedef double (*r_t) (unsigned*, size_t);
 
-struct ExperimentResult {
-    double result;
-    double time;
-};
-struct partialSumT {
-    alignas(64) double val;
-};
 
 typedef double (*I_t)(double, double, f_t);
 
@@ -34,10 +42,14 @@ double f(double x) {
     return x * x;
 }
 
+// The *Blocked kernels iterate their split_range block; the interleaved
+// i = t; i += T pattern in their counterparts makes adjacent threads share
+// every cache line they touch, which is the comparison the pairs exist for.
+
 double integrateDefault(double a, double b, f_t f) {
     double result = 0, dx = (b - a) / STEPS;
 
-    for (unsigned i = 0; i < STEPS; i++) {
+    for (size_t i = 0; i < STEPS; i++) {
         result += f(i * dx + a);
     }
 
@@ -53,7 +65,26 @@ double integrateCrit(double a, double b, f_t f) {
         unsigned t = (unsigned) omp_get_thread_num();
         unsigned T = (unsigned) get_num_threads();
 
-        for (unsigned i = t; i < STEPS; i += T) {
+        for (size_t i = t; i < STEPS; i += T) {
+            R += f(i * dx + a);
+        }
+#pragma omp critical
+        result += R;
+    }
+    return result * dx;
+}
+
+double integrateCritBlocked(double a, double b, f_t f) {
+    double result = 0, dx = (b - a) / STEPS;
+
+#pragma omp parallel
+    {
+        double R = 0;
+        unsigned t = (unsigned) omp_get_thread_num();
+        unsigned T = (unsigned) get_num_threads();
+        auto [lo, hi] = split_range(STEPS, T, t);
+
+        for (size_t i = lo; i < hi; i++) {
             R += f(i * dx + a);
         }
 #pragma omp critical
@@ -65,26 +96,40 @@ double integrateCrit(double a, double b, f_t f) {
 double integrateMutex(double a, double b, f_t f) {
     unsigned T = get_num_threads();
     mutex mtx;
-    vector<thread> threads;
     double result = 0, dx = (b - a) / STEPS;
 
-    for (unsigned t = 0; t < T; t++) {
-        threads.emplace_back([=, &result, &mtx]() {
-            double R = 0;
-            for (unsigned i = t; i < STEPS; i += T) {
-                R += f(i * dx + a);
-            }
+    run_on_pool(T, [=, &result, &mtx](unsigned t) {
+        double R = 0;
+        for (size_t i = t; i < STEPS; i += T) {
+            R += f(i * dx + a);
+        }
 
-            {
-                scoped_lock lck{mtx};
-                result += R;
-            }
-        });
+        {
+            scoped_lock lck{mtx};
+            result += R;
+        }
+    });
 
-    }
-    for (auto &thr: threads) {
-        thr.join();
-    }
+    return result * dx;
+}
+
+double integrateMutexBlocked(double a, double b, f_t f) {
+    unsigned T = get_num_threads();
+    mutex mtx;
+    double result = 0, dx = (b - a) / STEPS;
+
+    run_on_pool(T, [=, &result, &mtx](unsigned t) {
+        double R = 0;
+        auto [lo, hi] = split_range(STEPS, T, t);
+        for (size_t i = lo; i < hi; i++) {
+            R += f(i * dx + a);
+        }
+
+        {
+            scoped_lock lck{mtx};
+            result += R;
+        }
+    });
 
     return result * dx;
 }
@@ -104,7 +149,7 @@ double integrateArr(double a, double b, f_t f) {
             //accum1.reserve(T);
         }
 
-        for (unsigned i = t; i < STEPS; i += T) {
+        for (size_t i = t; i < STEPS; i += T) {
             accum[t] += f(dx * i + a);
         }
     }
@@ -118,28 +163,28 @@ double integrateArr(double a, double b, f_t f) {
     return result * dx;
 }
 
-double integrateArrAlign(double a, double b, f_t f) {
+double integrateArrBlocked(double a, double b, f_t f) {
     unsigned T;
     double result = 0, dx = (b - a) / STEPS;
-    partialSumT *accum = 0;
+    double *accum;
 
 #pragma omp parallel shared(accum, T)
     {
         unsigned t = (unsigned) omp_get_thread_num();
 #pragma omp single
         {
-            T = (unsigned) omp_get_num_threads();
-            accum = (partialSumT *) aligned_alloc(CACHE_LINE, T * sizeof(partialSumT));
-            memset(accum, 0, T*sizeof(*accum));
+            T = (unsigned) get_num_threads();
+            accum = (double *) calloc(T, sizeof(double));
         }
 
-        for (unsigned i = t; i < STEPS; i += T) {
-            accum[t].val += f(dx * i + a);
+        auto [lo, hi] = split_range(STEPS, T, t);
+        for (size_t i = lo; i < hi; i++) {
+            accum[t] += f(dx * i + a);
         }
     }
 
     for (unsigned i = 0; i < T; ++i) {
-        result += accum[i].val;
+        result += accum[i];
     }
 
     free(accum);
@@ -147,11 +192,68 @@ double integrateArrAlign(double a, double b, f_t f) {
     return result * dx;
 }
 
+double integrateArrAlign(double a, double b, f_t f) {
+    unsigned T = get_num_threads();
+    double result = 0, dx = (b - a) / STEPS;
+    per_thread_array<double> accum{T};
+
+#pragma omp parallel
+    {
+        unsigned t = (unsigned) omp_get_thread_num();
+
+        for (size_t i = t; i < STEPS; i += T) {
+            accum[t] += f(dx * i + a);
+        }
+    }
+
+    for (unsigned i = 0; i < T; ++i) {
+        result += accum[i];
+    }
+
+    return result * dx;
+}
+
+// Takes the integrand as a template parameter instead of f_t so the call
+// inlines and the inner loop vectorizes; the scalar variants above all go
+// through a function pointer, which blocks this entirely. Each thread owns a
+// contiguous block and an aligned partial sum like in integrateArrAlign.
+template<class F>
+double integrateSimd(double a, double b, F f) {
+    unsigned T = get_num_threads();
+    double result = 0, dx = (b - a) / STEPS;
+    per_thread_array<double> accum{T};
+
+#pragma omp parallel
+    {
+        unsigned t = (unsigned) omp_get_thread_num();
+
+        auto [lo, hi] = split_range(STEPS, T, t);
+        double R = 0;
+#pragma omp simd reduction(+: R)
+        for (size_t i = lo; i < hi; ++i) {
+            R += f(dx * i + a);
+        }
+        accum[t] = R;
+    }
+
+    for (unsigned i = 0; i < T; ++i) {
+        result += accum[i];
+    }
+
+    return result * dx;
+}
+
+// I_t-compatible wrapper; the f_t argument is ignored on purpose — passing it
+// through would reintroduce the pointer indirection integrateSimd avoids.
+double integrateSimdKernel(double a, double b, f_t) {
+    return integrateSimd(a, b, [](double x) { return x * x; });
+}
+
 double integrateReduction(double a, double b, f_t f) {
     double result = 0, dx = (b - a) / STEPS;
 
 #pragma omp parallel for reduction(+: result)
-    for (unsigned int i = 0; i < STEPS; ++i) {
+    for (size_t i = 0; i < STEPS; ++i) {
         result += f(dx * i + a);
     }
 
@@ -162,96 +264,236 @@ double integratePS(double a, double b, f_t f) {
     double dx = (b - a) / STEPS;
     double result = 0;
     unsigned T = get_num_threads();
-    auto vec = vector(T, partialSumT{0.0});
-    vector<thread> threadVec;
+    per_thread_array<double> vec{T};
 
-    auto threadProc = [=, &vec](auto t) {
-        for (auto i = t; i < STEPS; i += T) {
-            vec[t].val += f(dx * i + a);
+    run_on_pool(T, [=, &vec](unsigned t) {
+        PROF_START(t);
+        for (size_t i = t; i < STEPS; i += T) {
+            vec[t] += f(dx * i + a);
         }
-    };
+        PROF_PHASE(t, prof_compute);
+    });
 
-    for (auto t = 1; t < T; t++) {
-        threadVec.emplace_back(threadProc, t);
+    for (unsigned t = 0; t < T; ++t) {
+        result += vec[t];
     }
 
-    threadProc(0);
+    return result * dx;
+}
 
-    for (auto &thread: threadVec) {
-        thread.join();
-    }
+double integratePSBlocked(double a, double b, f_t f) {
+    double dx = (b - a) / STEPS;
+    double result = 0;
+    unsigned T = get_num_threads();
+    per_thread_array<double> vec{T};
+
+    run_on_pool(T, [=, &vec](unsigned t) {
+        auto [lo, hi] = split_range(STEPS, T, t);
+        for (size_t i = lo; i < hi; i++) {
+            vec[t] += f(dx * i + a);
+        }
+    });
 
-    for (auto elem: vec) {
-        result += elem.val;
+    for (unsigned t = 0; t < T; ++t) {
+        result += vec[t];
     }
 
     return result * dx;
 }
 
+// fetch_add on atomic<double> only exists since C++20; older toolchains
+// compile operator+= down to a CAS loop. One explicit helper so both paths
+// are visible and the benchmark measures what actually runs.
+inline void atomic_add_double(std::atomic<double> &a, double x) {
+#if defined(__cpp_lib_atomic_float)
+    a.fetch_add(x, std::memory_order_relaxed);
+#else
+    double cur = a.load(std::memory_order_relaxed);
+    while (!a.compare_exchange_weak(cur, cur + x, std::memory_order_relaxed)) {}
+#endif
+}
+
 double integrateAtomic(double a, double b, f_t f) {
-    vector<thread> threads;
     std::atomic<double> result = {0};
     double dx = (b - a) / STEPS;
     unsigned int T = get_num_threads();
 
-    auto fun = [dx, &result, f, a, T](auto t) {
+    run_on_pool(T, [dx, &result, f, a, T](unsigned t) {
         double R = 0;
-        for (unsigned i = t; i < STEPS; i += T) {
+        for (size_t i = t; i < STEPS; i += T) {
             R += f(i * dx + a);
         }
 
-        result += R;
-    };
-
-    for (unsigned int t = 1; t < T; ++t) {
-        threads.emplace_back(fun, t);
-    }
-
-    fun(0);
-
-    for (auto &thr: threads) {
-        thr.join();
-    }
+        atomic_add_double(result, R);
+    });
 
     return result * dx;
 }
 
-ExperimentResult runExperiment(I_t I) {
-    double t0, t1, result;
+double integrateAtomicBlocked(double a, double b, f_t f) {
+    std::atomic<double> result = {0};
+    double dx = (b - a) / STEPS;
+    unsigned int T = get_num_threads();
 
-    t0 = omp_get_wtime();
-    result = I(A, B, f);
-    t1 = omp_get_wtime();
+    run_on_pool(T, [dx, &result, f, a, T](unsigned t) {
+        double R = 0;
+        auto [lo, hi] = split_range(STEPS, T, t);
+        for (size_t i = lo; i < hi; i++) {
+            R += f(i * dx + a);
+        }
 
-    return {result, t1 - t0};
+        atomic_add_double(result, R);
+    });
+
+    return result * dx;
 }
 
-void showExperimentResults(I_t I) {
-    set_num_threads(1);
-    ExperimentResult R = runExperiment(I);
-    double T1 = R.time;
+typedef double (*h_t)(const unsigned*, size_t, unsigned, unsigned);
 
-    printf("%10s\t %10s\t %10s\n", "Result", "Time", "Acceleration");
+// Privatized histogram: each thread counts its contiguous block into its own
+// row of bins (rows padded out to whole cache lines, same idea as
+// integrateArrAlign's accum), merged serially at the end. With only
+// MAX-MIN+1 = 300 buckets the rows stay cache-resident and the kernel runs
+// at memory bandwidth. Returns the largest bucket count as a check value.
+double histogram(const unsigned* V, size_t n, unsigned min, unsigned max) {
+    unsigned bins_n = max - min + 1;
+    unsigned T = get_num_threads();
+    size_t line = hardware_destructive_interference_size / sizeof(uint64_t);
+    size_t stride = (bins_n + line - 1) / line * line;
+    vector<uint64_t> rows(stride * T, 0);
+
+    run_on_pool(T, [&rows, V, n, min, T, stride](unsigned t) {
+        uint64_t *row = rows.data() + t * stride;
+        auto [lo, hi] = split_range(n, T, t);
+        for (size_t i = lo; i < hi; ++i)
+            row[V[i] - min]++;
+    });
+
+    uint64_t best = 0;
+    for (unsigned b = 0; b < bins_n; ++b) {
+        uint64_t c = 0;
+        for (unsigned t = 0; t < T; ++t)
+            c += rows[t * stride + b];
+        if (c > best)
+            best = c;
+    }
+    return (double) best;
+}
 
-    printf("%10g\t %10g\t% 10g\n", R.result, R.time, T1/R.time);
-    // printf("%d,%g,%g\n", 1, R.time, T1 / R.time);
+// Naive variant for comparison: one shared bin array updated with atomics,
+// so every increment contends on the same 300 counters.
+double histogramAtomic(const unsigned* V, size_t n, unsigned min, unsigned max) {
+    unsigned bins_n = max - min + 1;
+    unsigned T = get_num_threads();
+    vector<atomic<uint64_t>> bins(bins_n);
+
+    run_on_pool(T, [&bins, V, n, min, T](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        for (size_t i = lo; i < hi; ++i)
+            bins[V[i] - min].fetch_add(1, memory_order_relaxed);
+    });
+
+    uint64_t best = 0;
+    for (unsigned b = 0; b < bins_n; ++b)
+        if (bins[b] > best)
+            best = bins[b];
+    return (double) best;
+}
 
-    for (int T = 2; T <= omp_get_num_procs(); ++T) {
+// Contention microbenchmark: the integrateAtomic kernels only ever do one
+// atomic add per thread, which says nothing about atomic cost under load.
+// Sweeps updates-per-thread against three aggregation strategies — one
+// shared atomic, per-thread padded slots, and sharded padded atomics with a
+// final reduce — so the crossover between them is measurable per machine.
+void atomicContentionExperiment() {
+    constexpr unsigned shards = 8;
+    const size_t max_updates = 1u << 20;
+
+    printf("%4s\t %10s\t %12s\t %12s\t %12s\n",
+           "T", "updates", "single", "padded", "sharded");
+    for (int T = 1; T <= omp_get_num_procs(); ++T) {
         set_num_threads(T);
-        ExperimentResult result = runExperiment(I);
-        printf("%10g\t %10g\t %10g\n", result.result, result.time, T1/result.time);
-        // printf("%d,%g,%g\n", T, result.time, T1 / result.time);
+        for (size_t updates = 1; updates <= max_updates; updates *= 16) {
+            std::atomic<double> single = {0};
+            double t0 = timer_seconds();
+            run_on_pool(T, [&single, updates](unsigned t) {
+                for (size_t i = 0; i < updates; ++i)
+                    atomic_add_double(single, (double) i);
+            });
+            double t_single = timer_elapsed(t0, timer_seconds());
+
+            per_thread_array<double> slots{(unsigned) T};
+            t0 = timer_seconds();
+            run_on_pool(T, [&slots, updates](unsigned t) {
+                for (size_t i = 0; i < updates; ++i)
+                    slots[t] += (double) i;
+            });
+            double slots_result = 0;
+            for (int t = 0; t < T; ++t)
+                slots_result += slots[t];
+            double t_padded = timer_elapsed(t0, timer_seconds());
+
+            per_thread_array<std::atomic<double>> shard_arr{shards};
+            t0 = timer_seconds();
+            run_on_pool(T, [&shard_arr, updates](unsigned t) {
+                auto &shard = shard_arr[t % shards];
+                for (size_t i = 0; i < updates; ++i)
+                    atomic_add_double(shard, (double) i);
+            });
+            double shard_result = 0;
+            for (unsigned s = 0; s < shards; ++s)
+                shard_result += shard_arr[s];
+            double t_sharded = timer_elapsed(t0, timer_seconds());
+
+            if (single != slots_result || single != shard_result)
+                printf("strategy results disagree at T=%d updates=%zu\n", T, updates);
+            printf("%4d\t %10zu\t %12g\t %12g\t %12g\n",
+                   T, updates, t_single, t_padded, t_sharded);
+        }
     }
-
     cout << endl;
 }
 
+ExperimentResult runExperiment(I_t I) {
+    double t0, t1, result;
+
+    prof_reset(get_num_threads());
+    t0 = timer_seconds();
+    result = I(A, B, f);
+    t1 = timer_seconds();
+    prof_report(get_num_threads());
+
+    return {result, timer_elapsed(t0, t1)};
+}
+
 double integrate_reduction(double a, double b, f_t F)
 {
     double dx = (b-a)/STEPS;
     return reduce_range(a, b, STEPS, F, [](auto x, auto y){return x + y;}, 0.0)*dx;
 }
 
+// Tolerance-based counterpart of the fixed-grid kernels: evaluation count is
+// set by the integrand's local error, not by STEPS.
+double integrateAdaptive(double a, double b, f_t F)
+{
+    return integrate_adaptive(a, b, F, 1e-9);
+}
+
+// Dynamic scheduling for integrands with non-uniform cost: threads pull
+// guided chunks from an atomic counter instead of owning a static block, so
+// the join no longer waits on whichever thread drew the expensive region.
+double integrateDynamic(double a, double b, f_t F)
+{
+    double dx = (b-a)/STEPS;
+    return reduce_range_dynamic(a, b, (size_t) STEPS, F, [](auto x, auto y){return x + y;}, 0.0)*dx;
+}
+
+double integrate_reduction_kahan(double a, double b, f_t F)
+{
+    double dx = (b-a)/STEPS;
+    return reduce_range_kahan(a, b, STEPS, F, 0.0)*dx;
+}
+
 unsigned Fibonacci(unsigned n)
 {
     if (n <= 2)
@@ -261,20 +503,33 @@ unsigned Fibonacci(unsigned n)
 
 
 
+// Exact linear-time Fibonacci (memoizes the last two values in registers);
+// the recursive versions above exist to generate task trees, this one is for
+// checking their results without burning 2^n additions.
+unsigned FibonacciIter(unsigned n)
+{
+    unsigned prev = 1, cur = 1;
+    for (unsigned i = 3; i <= n; ++i) {
+        unsigned next = prev + cur;
+        prev = cur;
+        cur = next;
+    }
+    return cur;
+}
+
+#define FIB_CUTOFF 20
+
 unsigned FibonacciNew(unsigned n)
 {
-    if (n <= 2)
-        return 1;
+    if (n <= FIB_CUTOFF)
+        return Fibonacci(n);
     unsigned x1, x2;
-#pragma omp task shared(x1)
-    {
+    task_group g;
+    g.spawn([&x1, n] {
         x1 = FibonacciNew(n - 1);
-    }
-#pragma omp task shared(x2)
-    {
-        x2 = FibonacciNew(n -2);
-    }
-#pragma omp taskwait
+    });
+    x2 = FibonacciNew(n - 2);
+    g.sync();
     return x1 + x2;
 }
 
@@ -297,29 +552,74 @@ unsigned FibonacciNew(unsigned n)
 ExperimentResult runExperimentFib() {
     double t0, t1, result;
 
-    t0 = omp_get_wtime();
+    t0 = timer_seconds();
     result = FibonacciNew(30);
-    t1 = omp_get_wtime();
+    t1 = timer_seconds();
+
+    if (result != FibonacciIter(30))
+        printf("FibonacciNew(30) wrong: %g\n", result);
 
-    return {result, t1 - t0};
+    return {result, timer_elapsed(t0, t1)};
 }
 
-void experimentFibonacci() {
-    set_num_threads(1);
-    ExperimentResult R = runExperimentFib();
-    double T1 = R.time;
-    printf("%10s\t %10s\t %10s\n", "Result", "Time", "Acceleration");
+// Binary task tree with a tunable per-leaf compute cost: every leaf spins
+// leaf_work dependent multiply-adds, every level above `cutoff` spawns its
+// left child as a task. FibonacciNew(30) spawns millions of nanosecond
+// tasks, which measures nothing but runtime overhead; this workload lets
+// cutoff and leaf cost vary so the overhead per task can be extracted.
+double grainTree(unsigned depth, unsigned cutoff, unsigned leaf_work)
+{
+    if (depth == 0) {
+        double x = 1.0;
+        for (unsigned i = 0; i < leaf_work; ++i)
+            x = x * 1.000000001 + 1e-9;
+        return x;
+    }
+    if (depth <= cutoff)
+        return grainTree(depth - 1, cutoff, leaf_work)
+             + grainTree(depth - 1, cutoff, leaf_work);
+    double x1, x2;
+    task_group g;
+    g.spawn([&x1, depth, cutoff, leaf_work] {
+        x1 = grainTree(depth - 1, cutoff, leaf_work);
+    });
+    x2 = grainTree(depth - 1, cutoff, leaf_work);
+    g.sync();
+    return x1 + x2;
+}
 
-    printf("%10g\t %10g\t% 10g\n", R.result, R.time, T1/R.time);
-    // printf("%d,%g,%g\n", 1, R.time, T1 / R.time);
+// Sweeps cutoff x threads for a fixed tree and reports the overhead per
+// spawned task: (CPU time of the run) minus (single-thread fully-inline
+// time), divided by the number of spawns. That figure is what sizes task
+// granularity in services built on the scheduler.
+void taskGranularityExperiment() {
+    const unsigned depth = 16;
+    const unsigned leaf_work = 256;
 
-    for (int T = 2; T <= omp_get_num_procs(); ++T) {
+    set_num_threads(1);
+    // Untimed warm-up pass: inline_time is the reference every cell below is
+    // compared against, so it must not also pay the first run's cold caches
+    // and untrained predictors.
+    volatile double sink = grainTree(depth, depth, leaf_work);
+    double t0 = timer_seconds();
+    sink = grainTree(depth, depth, leaf_work);
+    double inline_time = timer_elapsed(t0, timer_seconds());
+    (void) sink;
+
+    printf("%4s\t %6s\t %8s\t %10s\t %14s\n",
+           "T", "cutoff", "tasks", "Time", "Overhead/task");
+    for (int T = 1; T <= omp_get_num_procs(); ++T) {
         set_num_threads(T);
-        ExperimentResult result = runExperimentFib();
-        printf("%10g\t %10g\t %10g\n", result.result, result.time, T1/result.time);
-        // printf("%d,%g,%g\n", T, result.time, T1 / result.time);
+        for (unsigned cutoff = 0; cutoff <= depth; cutoff += 2) {
+            unsigned long tasks = (1ul << (depth - cutoff)) - 1;
+            t0 = timer_seconds();
+            sink = grainTree(depth, cutoff, leaf_work);
+            double time = timer_elapsed(t0, timer_seconds());
+            double overhead = tasks ? (time * T - inline_time) / (double) tasks : 0;
+            printf("%4d\t %6u\t %8lu\t %10g\t %14g\n",
+                   T, cutoff, tasks, time, overhead);
+        }
     }
-
     cout << endl;
 }
 
@@ -349,127 +649,459 @@ double randomize_arr_single(unsigned* V, size_t n){
 }
 
 
-uint64_t getA(unsigned size, uint64_t a){
-    uint64_t res = 1;
-    for (unsigned i=1; i<=size; i++) res = res * a;
-    return res;
+// k-step jump of the affine map x -> a*x + b (mod 2^64) by squaring the map:
+// x_{i+k} = A*x_i + B. O(log k) instead of the O(k) loops getA/getB used.
+void lcg_jump(uint64_t a, uint64_t b, uint64_t k, uint64_t &mul, uint64_t &add) {
+    mul = 1;
+    add = 0;
+    while (k) {
+        if (k & 1) {
+            mul = a * mul;
+            add = a * add + b;
+        }
+        b = a * b + b;
+        a = a * a;
+        k >>= 1;
+    }
 }
 
-uint64_t getB(unsigned size, uint64_t a){
-    uint64_t* acc = new uint64_t(size);
-    uint64_t res = 1;
-    acc[0] = 1;
-    for (unsigned i=1; i<=size; i++){
-        for (unsigned j=0; j<i; j++){
-            acc[i] = acc[j] * a;
+double randomize_arr_fs(unsigned* V, size_t n){
+    uint64_t a = 6364136223846793005;
+    uint64_t b = 1;
+    unsigned T = get_num_threads();
+    uint64_t jumpA, jumpB;
+    lcg_jump(a, b, T, jumpA, jumpB);
+    per_thread_array<double> sums{T};
+
+#pragma omp parallel shared(V)
+    {
+        unsigned t = (unsigned) omp_get_thread_num();
+        uint64_t At, Bt;
+        lcg_jump(a, b, t + 1, At, Bt);
+        uint64_t cur = At * SEED + Bt;
+        double S = 0;
+
+        for (size_t i = t; i < n; i += T){
+            V[i] = (cur % (MAX - MIN + 1)) + MIN;
+            S += V[i];
+            cur = jumpA * cur + jumpB;
         }
-        res += acc[i];
+        sums[t] = S;
     }
-    return res;
+
+    double sum = 0;
+    for (unsigned i = 0; i < T; ++i)
+        sum += sums[i];
+
+    return sum/(double)n;
 }
 
-double randomize_arr_fs(unsigned* V, size_t n){
+// Blocked variant: each thread fills a contiguous chunk of V, so the stream
+// inside the block advances with the plain one-step recurrence and only the
+// block start needs a jump. No cache line of V is shared between threads.
+double randomize_arr_fs_blocked(unsigned* V, size_t n){
     uint64_t a = 6364136223846793005;
-    unsigned b = 1;
-    unsigned T;
-//    uint64_t* LUTA;
-//    uint64_t* LUTB;
-    uint64_t LUTA;
-    uint64_t LUTB;
-    uint64_t sum = 0;
+    uint64_t b = 1;
+    unsigned T = get_num_threads();
+    per_thread_array<double> sums{T};
 
-#pragma omp parallel shared(V, T, LUTA, LUTB)
+#pragma omp parallel shared(V)
     {
         unsigned t = (unsigned) omp_get_thread_num();
-#pragma omp single
-        {
-            T = (unsigned) get_num_threads();
-//            LUTA = getLUTA(n, a);
-//            LUTB = getLUTB(n, LUTA, b);
-            LUTA = getA(T, a);
-            LUTB = getB((T - 1), a)*b;
+        auto [lo, hi] = split_range(n, T, t);
+        uint64_t At, Bt;
+        lcg_jump(a, b, lo + 1, At, Bt);
+        uint64_t cur = At * SEED + Bt;
+        double S = 0;
+
+        for (size_t i = lo; i < hi; i++){
+            V[i] = (cur % (MAX - MIN + 1)) + MIN;
+            S += V[i];
+            cur = a * cur + b;
         }
-        uint64_t prev = SEED;
-        uint64_t cur;
-
-        for (unsigned i=t; i<n; i += T){
-            if (i == t){
-                cur = getA(i+1, a)*prev + getB(i, a) * b;
-            } else {
-                cur = LUTA*prev + LUTB;
+        sums[t] = S;
+    }
+
+    double sum = 0;
+    for (unsigned i = 0; i < T; ++i)
+        sum += sums[i];
+
+    return sum/(double)n;
+}
+
+// Double integral of x^2 + y^2 over [A, B]^2 with a grid costing the same
+// STEPS evaluations as the 1D kernels. The closed form is 8/3 for [-1, 1]^2,
+// so this doubles as a correctness check when registered.
+ExperimentResult runExperiment2d() {
+    auto n = (size_t) sqrt((double) STEPS);
+
+    double t0 = timer_seconds();
+    double result = integrate2d(A, B, A, B, n, n,
+                                [](double x, double y) { return x * x + y * y; });
+    double t1 = timer_seconds();
+
+    return {result, timer_elapsed(t0, t1)};
+}
+
+// Batched variant: K independent LCG lanes per thread, each advanced K
+// steps at a time with jump-ahead constants, so the K state updates per
+// iteration have no dependency chain between them and the store covers a
+// full cache line of outputs. The modulo becomes a Lemire multiply-shift —
+// the high 32 state bits times the range, keeping the top half — so the
+// dependent divide leaves the hot path. Same stream positions as the other
+// randomizers, but the value mapping differs from `% range`, so means agree
+// statistically rather than bit-for-bit.
+double randomize_arr_batched(unsigned* V, size_t n){
+    constexpr unsigned K = 16;   // 16 unsigneds = one 64-byte line per iteration
+    uint64_t a = 6364136223846793005;
+    uint64_t b = 1;
+    const uint64_t range = MAX - MIN + 1;
+    unsigned T = get_num_threads();
+    per_thread_array<double> sums{T};
+
+#pragma omp parallel shared(V)
+    {
+        unsigned t = (unsigned) omp_get_thread_num();
+        auto [lo, hi] = split_range(n, T, t);
+        uint64_t Ak, Bk;
+        lcg_jump(a, b, K, Ak, Bk);
+
+        uint64_t lane[K];
+        for (unsigned j = 0; j < K; ++j) {
+            uint64_t Aj, Bj;
+            lcg_jump(a, b, lo + j + 1, Aj, Bj);
+            lane[j] = Aj * SEED + Bj;
+        }
+
+        double S = 0;
+        size_t i = lo;
+        for (; i + K <= hi; i += K) {
+            for (unsigned j = 0; j < K; ++j) {
+                unsigned v = (unsigned) (((uint64_t) (uint32_t) (lane[j] >> 32) * range) >> 32) + MIN;
+                V[i + j] = v;
+                S += v;
+                lane[j] = Ak * lane[j] + Bk;
             }
-//            cur = LUTA[i+1]*prev + LUTB[i];
-            V[i] = (cur % (MAX - MIN + 1)) + MIN;
-            prev = cur;
         }
+
+        // Tail shorter than a batch: one-step recurrence from a jump to i.
+        uint64_t Ai, Bi;
+        lcg_jump(a, b, i + 1, Ai, Bi);
+        uint64_t cur = Ai * SEED + Bi;
+        for (; i < hi; ++i) {
+            unsigned v = (unsigned) (((uint64_t) (uint32_t) (cur >> 32) * range) >> 32) + MIN;
+            V[i] = v;
+            S += v;
+            cur = a * cur + b;
+        }
+        sums[t] = S;
     }
 
-    for (unsigned i=0; i<n;i++)
-        sum += V[i];
+    double sum = 0;
+    for (unsigned i = 0; i < T; ++i)
+        sum += sums[i];
 
-    return (double)sum/(double)n;
+    return sum/(double)n;
 }
 
-ExperimentResult runRandomizeExperiment(r_t f) {
-    size_t ArrayLength = 100000;
-    unsigned Array[ArrayLength];
-    unsigned Seed = 100;
+// Non-blocking launch of the blocked integration on a caller-chosen core
+// set. Workers write aligned partials; the returned future folds them on
+// get(), so the caller overlaps the kernel with whatever else it has to do
+// and pays the combine only when it asks for the answer.
+future<double> async_integrate(double a, double b, f_t F, core_set cs) {
+    unsigned T = cs.count;
+    size_t steps = STEPS;
+    double dx = (b - a) / steps;
+    auto partials = make_shared<per_thread_array<double>>(T);
+
+    auto workers = make_shared<future<void>>(run_on_cores_async(cs, [=](unsigned t) {
+        auto [lo, hi] = split_range(steps, T, t);
+        double R = 0;
+        for (size_t i = lo; i < hi; i++)
+            R += F(dx * i + a);
+        (*partials)[t] = R;
+    }));
+
+    return async(launch::deferred, [=] {
+        workers->wait();
+        double result = 0;
+        for (unsigned t = 0; t < T; ++t)
+            result += (*partials)[t];
+        return result * dx;
+    });
+}
 
-    double t0, t1, result;
+// Async counterpart of randomize_arr_fs_blocked on a core set; the future
+// yields the mean, same as the synchronous drivers report.
+future<double> async_randomize(unsigned* V, size_t n, core_set cs) {
+    uint64_t a = 6364136223846793005;
+    uint64_t b = 1;
+    unsigned T = cs.count;
+    auto sums = make_shared<per_thread_array<double>>(T);
+
+    auto workers = make_shared<future<void>>(run_on_cores_async(cs, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        uint64_t At, Bt;
+        lcg_jump(a, b, lo + 1, At, Bt);
+        uint64_t cur = At * SEED + Bt;
+        double S = 0;
+        for (size_t i = lo; i < hi; i++){
+            V[i] = (cur % (MAX - MIN + 1)) + MIN;
+            S += V[i];
+            cur = a * cur + b;
+        }
+        (*sums)[t] = S;
+    }));
+
+    return async(launch::deferred, [=] {
+        workers->wait();
+        double sum = 0;
+        for (unsigned t = 0; t < T; ++t)
+            sum += (*sums)[t];
+        return sum / (double) n;
+    });
+}
+
+// Overlap demo: integration on the low half of the machine, randomizer fill
+// on the high half, both in flight at once. The synchronous drivers would
+// run these back to back with half the cores idle in each phase.
+void asyncOverlapExperiment() {
+    unsigned P = (unsigned) omp_get_num_procs();
+    unsigned half = P / 2 ? P / 2 : 1;
+    core_set low{0, half};
+    core_set high{half, P > half ? P - half : 1};
+
+    auto *V = new unsigned[ARRAY_LENGTH];
 
-    t0 = omp_get_wtime();
-    result = f((unsigned *)&Array, ArrayLength);
-    t1 = omp_get_wtime();
+    double t0 = timer_seconds();
+    auto integral = async_integrate(A, B, f, low);
+    auto mean = async_randomize(V, ARRAY_LENGTH, high);
+    double I = integral.get(), R = mean.get();
+    double t1 = timer_seconds();
 
-    return {result, t1 - t0};
+    printf("async overlap: cores [0,%u) + [%u,%u)\n", low.count, high.first, high.first + high.count);
+    printf("integral=%g mean=%g time=%g\n", I, R, t1 - t0);
+
+    delete[] V;
 }
 
-void randomizeExperiment(r_t f) {
-    set_num_threads(1);
-    ExperimentResult R = runRandomizeExperiment(f);
-    double T1 = R.time;
+#ifdef __linux__
+// Writes ARRAY_LENGTH doubles to a scratch file outside the timed region,
+// then times the double-buffered streaming reduce over it. Small chunks
+// relative to the file so the overlap path actually cycles both buffers.
+ExperimentResult runStreamReduceExperiment() {
+    static const char* path = "/tmp/parallel_stream_reduce.bin";
+    std::vector<double> v(ARRAY_LENGTH);
+    par::generate(par::static_policy{}, v.begin(), v.end(),
+                  [](size_t i) { return 1.0 / (1.0 + (double) i); });
+
+    FILE* out = fopen(path, "wb");
+    fwrite(v.data(), sizeof(double), v.size(), out);
+    fclose(out);
+
+    auto plus = [](double x, double y) { return x + y; };
+    double t0 = timer_seconds();
+    double result = reduce_file<double>(path, plus, 0.0,
+                                        (ARRAY_LENGTH / 8) * sizeof(double));
+    double t1 = timer_seconds();
+
+    double expected = par::reduce(par::seq_policy{}, v.begin(), v.end(), 0.0, plus);
+    if (std::abs(result - expected) > 1e-6 * std::abs(expected))
+        printf("reduce_file mismatch: got %f, expected %f\n", result, expected);
+
+    remove(path);
+    return {result, timer_elapsed(t0, t1)};
+}
+#endif
+
+// Times the streaming reduce_vector (8 accumulator chains, prefetch 8 lines
+// ahead) over the same data par_reduce uses, cross-checked against a
+// sequential sum.
+ExperimentResult runReduceStreamExperiment() {
+    std::vector<double> v(ARRAY_LENGTH);
+    par::generate(par::static_policy{}, v.begin(), v.end(),
+                  [](size_t i) { return 1.0 / (1.0 + (double) i); });
+
+    auto plus = [](double x, double y) { return x + y; };
+    double t0 = timer_seconds();
+    double result = reduce_vector_stream(v.data(), v.size(), plus, 0.0);
+    double t1 = timer_seconds();
+
+    double expected = par::reduce(par::seq_policy{}, v.begin(), v.end(), 0.0, plus);
+    if (std::abs(result - expected) > 1e-6 * std::abs(expected))
+        printf("reduce_stream mismatch: got %f, expected %f\n", result, expected);
+
+    return {result, timer_elapsed(t0, t1)};
+}
 
+// Exercises the par:: façade: generate and reduce a vector through iterators
+// and a policy tag instead of raw pointers and f_t. Only the reduce is timed;
+// the seq-policy reduce cross-checks the answer.
+ExperimentResult runVectorApiExperiment() {
+    std::vector<double> v(ARRAY_LENGTH);
+    par::generate(par::static_policy{}, v.begin(), v.end(),
+                  [](size_t i) { return 1.0 / (1.0 + (double) i); });
 
-    printf("%10s\t %10s\t %10s\n", "Result", "Time", "Acceleration");
+    auto plus = [](double x, double y) { return x + y; };
+    double t0 = timer_seconds();
+    double result = par::reduce(par::simd_policy{}, v.begin(), v.end(), 0.0, plus);
+    double t1 = timer_seconds();
 
-    printf("%10g\t %10g\t% 10g\n", R.result, R.time, T1/R.time);
-    // printf("%d,%g,%g\n", 1, R.time, T1 / R.time);
+    double expected = par::reduce(par::seq_policy{}, v.begin(), v.end(), 0.0, plus);
+    if (std::abs(result - expected) > 1e-6 * std::abs(expected))
+        printf("par_reduce mismatch: got %f, expected %f\n", result, expected);
 
-    for (int T = 2; T <= omp_get_num_procs(); ++T) {
-        set_num_threads(T);
-        ExperimentResult result = runRandomizeExperiment(f);
-        printf("%10g\t %10g\t %10g\n", result.result, result.time, T1/result.time);
-        // printf("%d,%g,%g\n", T, result.time, T1 / result.time);
-    }
+    return {result, timer_elapsed(t0, t1)};
+}
 
-    cout << endl;
+// Fills V with the randomizer outside the timed region, then times only the
+// histogram pass over it.
+ExperimentResult runHistogramExperiment(h_t h) {
+    auto *Array = new unsigned[ARRAY_LENGTH];
+    randomize_arr_fs(Array, ARRAY_LENGTH);
+
+    double t0 = timer_seconds();
+    double result = h(Array, ARRAY_LENGTH, MIN, MAX);
+    double t1 = timer_seconds();
+
+    delete[] Array;
+
+    return {result, timer_elapsed(t0, t1)};
+}
+
+ExperimentResult runRandomizeExperiment(r_t f) {
+    size_t bytes = ARRAY_LENGTH * sizeof(unsigned);
+    // 2MB-aligned so the kernel can back large buffers with huge pages.
+    auto *Array = (unsigned *) aligned_alloc(1u << 21, (bytes + (1u << 21) - 1) & ~(size_t)((1u << 21) - 1));
+#ifdef __linux__
+    madvise(Array, bytes, MADV_HUGEPAGE);
+#endif
+    first_touch(Array, bytes);
+
+    double t0, t1, result;
+
+    t0 = timer_seconds();
+    result = f(Array, ARRAY_LENGTH);
+    t1 = timer_seconds();
+
+    free(Array);
+
+    return {result, timer_elapsed(t0, t1)};
 }
 
-int main() {
-    std::cout << "fibonacci" << std::endl;
-    experimentFibonacci();
-   std::cout << "fs randomizer" << std::endl;
-   randomizeExperiment(randomize_arr_fs);
-//    showExperimentResults(integrateDefault);
-//    std::cout << "integrateCrit" << std::endl;
-//    showExperimentResults(integrateCrit);
-//    std::cout << "integrateMutex" << std::endl;
-//    showExperimentResults(integrateMutex);
-//    std::cout << "integrateArr" << std::endl;
-//    showExperimentResults(integrateArr);
-//    std::cout << "integrateArrAlign" << std::endl;
-//    showExperimentResults(integrateArrAlign);
-//    std::cout << "integrateReduction" << std::endl;
-//    showExperimentResults(integrateReduction);
-//    std::cout << "integratePS" << std::endl;
-//    showExperimentResults(integratePS);
-//    std::cout << "integrateAtomic" << std::endl;
-//    showExperimentResults(integrateAtomic);
+// Every integrate strategy by name. Registering these unconditionally would
+// drag eighteen full-grid kernels into every default run, so they join the
+// registry only when --compare asks for them.
+static const struct { const char *name; I_t fn; } integrate_variants[] = {
+        {"integrateDefault", integrateDefault},
+        {"integrateCrit", integrateCrit},
+        {"integrateCritBlocked", integrateCritBlocked},
+        {"integrateMutex", integrateMutex},
+        {"integrateMutexBlocked", integrateMutexBlocked},
+        {"integrateArr", integrateArr},
+        {"integrateArrBlocked", integrateArrBlocked},
+        {"integrateArrAlign", integrateArrAlign},
+        {"integrateReduction", integrateReduction},
+        {"integratePS", integratePS},
+        {"integratePSBlocked", integratePSBlocked},
+        {"integrateAtomic", integrateAtomic},
+        {"integrateAtomicBlocked", integrateAtomicBlocked},
+        {"integrateSimd", integrateSimdKernel},
+        {"integrate_reduction", integrate_reduction},
+        {"integrate_reduction_kahan", integrate_reduction_kahan},
+        {"integrateDynamic", integrateDynamic},
+        {"integrateAdaptive", integrateAdaptive},
+};
 
-//    showExperimentResults(integrate_reduction);
+static void registerIntegrateVariants() {
+    for (const auto &v: integrate_variants) {
+        I_t fn = v.fn;
+        register_benchmark(v.name, [fn] { return runExperiment(fn); });
+    }
+}
 
+int main(int argc, char **argv) {
+    output_format fmt;
+    unsigned reps, warmup;
+    parse_benchmark_args(argc, argv, fmt, reps, warmup);
+
+    size_t sweep_min = 0, sweep_max = 0;
+    const char *record_path = nullptr, *check_path = nullptr;
+    char *compare_arg = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--grain")) {
+            taskGranularityExperiment();
+            return 0;
+        }
+        if (!strcmp(argv[i], "--contention")) {
+            atomicContentionExperiment();
+            return 0;
+        }
+        if (!strcmp(argv[i], "--async")) {
+            asyncOverlapExperiment();
+            return 0;
+        }
+        if (!strncmp(argv[i], "--steps=", 8))
+            STEPS = strtoull(argv[i] + 8, nullptr, 10);
+        if (!strncmp(argv[i], "--length=", 9))
+            ARRAY_LENGTH = strtoull(argv[i] + 9, nullptr, 10);
+        if (!strncmp(argv[i], "--compare", 9))
+            compare_arg = argv[i];
+        if (!strncmp(argv[i], "--record=", 9))
+            record_path = argv[i] + 9;
+        if (!strncmp(argv[i], "--check=", 8))
+            check_path = argv[i] + 8;
+        sscanf(argv[i], "--sweep=%zu:%zu", &sweep_min, &sweep_max);
+    }
 
+    register_benchmark("fibonacci", [] { return runExperimentFib(); });
+    register_benchmark("randomize_fs", [] { return runRandomizeExperiment(randomize_arr_fs); });
+    register_benchmark("randomize_fs_blocked", [] { return runRandomizeExperiment(randomize_arr_fs_blocked); });
+    register_benchmark("randomize_batched", [] { return runRandomizeExperiment(randomize_arr_batched); });
+    register_benchmark("histogram", [] { return runHistogramExperiment(histogram); });
+    register_benchmark("histogram_atomic", [] { return runHistogramExperiment(histogramAtomic); });
+    register_benchmark("par_reduce", [] { return runVectorApiExperiment(); });
+    register_benchmark("reduce_stream", [] { return runReduceStreamExperiment(); });
+    register_benchmark("integrate2d", [] { return runExperiment2d(); });
+#ifdef __linux__
+    register_benchmark("reduce_file", [] { return runStreamReduceExperiment(); });
+#endif
+    // The integrate variants live in integrate_variants[] and are measured
+    // head to head via --compare[=name,name,...].
+
+    if (compare_arg) {
+        registerIntegrateVariants();
+        vector<string> names;
+        if (compare_arg[9] == '=') {
+            // Comma-separated selection; the first name is the serial
+            // reference the ranking's speedup column divides by.
+            for (char *tok = strtok(compare_arg + 10, ","); tok; tok = strtok(nullptr, ","))
+                names.emplace_back(tok);
+        } else {
+            for (const auto &v: integrate_variants)
+                names.emplace_back(v.name);
+        }
+        run_comparison(names, reps, warmup);
+        return 0;
+    }
+
+    if (record_path) {
+        record_baseline(record_path, reps, warmup);
+        return 0;
+    }
+    if (check_path)
+        return check_baseline(check_path, reps, warmup) ? 1 : 0;
+
+    if (sweep_max) {
+        set_problem_size_hook([](size_t n) {
+            STEPS = n;
+            ARRAY_LENGTH = n;
+        });
+        run_size_sweep(fmt, reps, sweep_min, sweep_max, warmup);
+        return 0;
+    }
 
+    run_benchmarks(fmt, reps, warmup);
 
     return 0;
 }
@@ -0,0 +1,148 @@
+#ifndef PARALLEL_PAR_H
+#define PARALLEL_PAR_H
+
+#include <cstddef>
+#include <memory>
+#include "threads.h"
+#include "accumulators.h"
+#include "reduction.cpp"
+
+// Iterator + execution-policy front end over the raw-pointer kernels.
+// The policy is a tag type resolved by overload selection at compile time,
+// so the functor flows through as a template parameter and inlines all the
+// way into the inner loop — none of the f_t pointer indirection that blocks
+// inlining and vectorization in the integrate* kernels.
+//
+//     double s = par::reduce(par::static_policy{}, v.begin(), v.end(),
+//                            0.0, [](auto x, auto y) { return x + y; });
+//
+// Iterators must be contiguous (vector, array, pointers). For reduce, init
+// must be the identity of op: it also seeds the per-thread accumulators.
+namespace par {
+
+struct seq_policy {};
+struct static_policy {};                              // blocked static split
+struct dynamic_policy { std::size_t chunk = 1024; };  // guided steal-able chunks
+struct simd_policy {};                                // unrolled accumulator chains
+
+template <class It, class T, class BinaryFn>
+T reduce(seq_policy, It first, It last, T init, BinaryFn op) {
+    for (; first != last; ++first)
+        init = op(init, *first);
+    return init;
+}
+
+template <class It, class T, class BinaryFn>
+T reduce(static_policy, It first, It last, T init, BinaryFn op) {
+    return transform_reduce(std::to_address(first), (std::size_t) (last - first),
+                            [](T x) { return x; }, op, init);
+}
+
+template <class It, class T, class BinaryFn>
+T reduce(dynamic_policy p, It first, It last, T init, BinaryFn op) {
+    auto V = std::to_address(first);
+    std::size_t n = last - first;
+    unsigned T_ = get_num_threads();
+    auto partials = static_cast<padded_accumulator<T>*>(
+            reduction_scratch(T_ * sizeof(padded_accumulator<T>)));
+    dynamic_ranges ranges{n, p.chunk, T_, true};
+
+    run_on_pool(T_, [=, &ranges](unsigned t) {
+        T accum = init;
+        std::size_t lo, hi;
+        while (ranges.grab(lo, hi))
+            for (std::size_t i = lo; i < hi; ++i)
+                accum = op(accum, V[i]);
+        partials[t].value = accum;
+    });
+
+    T result = init;
+    for (unsigned t = 0; t < T_; ++t)
+        result = op(result, partials[t].value);
+    return result;
+}
+
+template <class It, class T, class BinaryFn>
+T reduce(simd_policy, It first, It last, T init, BinaryFn op) {
+    auto V = std::to_address(first);
+    std::size_t n = last - first;
+    unsigned T_ = get_num_threads();
+    auto partials = static_cast<padded_accumulator<T>*>(
+            reduction_scratch(T_ * sizeof(padded_accumulator<T>)));
+
+    run_on_pool(T_, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T_, t);
+        // Four independent chains: hides the FP op latency of the single
+        // accum = op(accum, V[i]) dependency and gives the vectorizer lanes.
+        T c0 = init, c1 = init, c2 = init, c3 = init;
+        std::size_t i = lo;
+        for (; i + 4 <= hi; i += 4) {
+            c0 = op(c0, V[i]);
+            c1 = op(c1, V[i + 1]);
+            c2 = op(c2, V[i + 2]);
+            c3 = op(c3, V[i + 3]);
+        }
+        T accum = op(op(c0, c1), op(c2, c3));
+        for (; i < hi; ++i)
+            accum = op(accum, V[i]);
+        partials[t].value = accum;
+    });
+
+    T result = init;
+    for (unsigned t = 0; t < T_; ++t)
+        result = op(result, partials[t].value);
+    return result;
+}
+
+template <class It, class OutIt, class UnaryFn>
+void transform(seq_policy, It first, It last, OutIt out, UnaryFn fn) {
+    for (; first != last; ++first, ++out)
+        *out = fn(*first);
+}
+
+template <class It, class OutIt, class UnaryFn>
+void transform(static_policy, It first, It last, OutIt out, UnaryFn fn) {
+    ::transform(std::to_address(first), std::to_address(out),
+                (std::size_t) (last - first), fn);
+}
+
+template <class It, class OutIt, class UnaryFn>
+void transform(simd_policy, It first, It last, OutIt out, UnaryFn fn) {
+    auto in = std::to_address(first);
+    auto o = std::to_address(out);
+    std::size_t n = last - first;
+    unsigned T_ = get_num_threads();
+
+    run_on_pool(T_, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T_, t);
+#pragma omp simd
+        for (std::size_t i = lo; i < hi; ++i)
+            o[i] = fn(in[i]);
+    });
+}
+
+// gen is called with the element index so parallel generation stays
+// deterministic regardless of T.
+template <class It, class GenFn>
+void generate(static_policy, It first, It last, GenFn gen) {
+    auto V = std::to_address(first);
+    std::size_t n = last - first;
+    unsigned T_ = get_num_threads();
+
+    run_on_pool(T_, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T_, t);
+        for (std::size_t i = lo; i < hi; ++i)
+            V[i] = gen(i);
+    });
+}
+
+template <class It, class GenFn>
+void generate(seq_policy, It first, It last, GenFn gen) {
+    std::size_t i = 0;
+    for (; first != last; ++first, ++i)
+        *first = gen(i);
+}
+
+}
+
+#endif //PARALLEL_PAR_H
@@ -1,105 +1,476 @@
+// Include guard: historically this file is #include'd as a .cpp (it is all
+// templates); par.h pulls it in too, so guard against double inclusion.
+#ifndef PARALLEL_REDUCTION_CPP
+#define PARALLEL_REDUCTION_CPP
+
 #include <thread>
 #include <vector>
 #include <iostream>
-#include <barrier>
-
-#ifdef __cpp_lib_hardware_interference_size
-    using std::hardware_constructive_interference_size;
-    using std::hardware_destructive_interference_size;
-#else
-    constexpr std::size_t hardware_constructive_interference_size = 64;
-    constexpr std::size_t hardware_destructive_interference_size = 64;
-#endif
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+#include "threads.h"
+#include "task_scheduler.h"
+#include "accumulators.h"
+#include "instrument.h"
 
-unsigned get_num_threads();
-
-void set_num_threads(unsigned T);
 
 auto ceil_div(auto x, auto y) {
     return (x + y - 1) / y;
 }
 
+// Per-caller scratch for partial-result arrays. thread_local so reductions
+// running concurrently from different threads get disjoint storage (the old
+// function-static vectors raced), and the allocation is kept and regrown
+// only when a larger T shows up, so repeated calls allocate nothing.
+inline void* reduction_scratch(std::size_t bytes) {
+    class scratch_arena {
+        void* ptr = nullptr;
+        std::size_t cap = 0;
+    public:
+        ~scratch_arena() { std::free(ptr); }
+
+        void* get(std::size_t bytes) {
+            if (cap < bytes) {
+                std::free(ptr);
+                std::size_t align = hardware_destructive_interference_size;
+                ptr = std::aligned_alloc(align, ceil_div(bytes, align) * align);
+                cap = bytes;
+            }
+            return ptr;
+        }
+    };
+    static thread_local scratch_arena arena;
+    return arena.get(bytes);
+}
+
+// Partial result plus the publication flag for the barrier-free tree
+// combine. level = r means the value is ready for consumption in combine
+// round r; owner and flag share the line on purpose — only the direct
+// partner ever reads them, and it wants both.
+template <class ElementType>
+struct alignas(hardware_destructive_interference_size) combine_slot {
+    ElementType value;
+    std::atomic<unsigned> level;
+};
+
+// Pairwise tree combine without global barriers: each thread publishes its
+// partial with a release store and only the thread that consumes it spins
+// (acquire) on that one flag. Threads that lose the (t % 2s) test at round r
+// return immediately instead of blocking through log2(T) all-thread
+// barriers, and nobody waits on threads outside its own subtree. Caller must
+// zero the level flags before dispatch — the scratch arena is reused.
+template <class ElementType, class BinaryFn>
+void tree_combine(combine_slot<ElementType>* slots, unsigned T, unsigned t, BinaryFn reduce_2) {
+    slots[t].level.store(1, std::memory_order_release);
+    unsigned r = 1;
+    for (std::size_t s = 1, s_next = 2; s < T; s = s_next, s_next += s_next, ++r) {
+        if ((t % s_next) != 0)
+            return;         // partial is published; the partner picks it up
+        if (t + s < T) {
+            while (slots[t + s].level.load(std::memory_order_acquire) < r)
+                std::this_thread::yield();
+            PROF_PHASE(t, prof_sync);
+            slots[t].value = reduce_2(slots[t].value, slots[t + s].value);
+            PROF_PHASE(t, prof_combine);
+        }
+        slots[t].level.store(r + 1, std::memory_order_release);
+    }
+}
+
 template <class ElementType, class BinaryFn>
 ElementType reduce_vector(const ElementType* V, std::size_t n, BinaryFn f, ElementType zero) {
 
-    struct reduction_partial_result_t {
-        alignas(hardware_destructive_interference_size) ElementType value;
-    };
     unsigned T = get_num_threads();
-    static auto reduction_partial_results = std::vector<reduction_partial_result_t>(T, reduction_partial_result_t{zero});
+    auto slots = static_cast<combine_slot<ElementType>*>(
+            reduction_scratch(T * sizeof(combine_slot<ElementType>)));
+    for (unsigned t = 0; t < T; ++t) {
+        slots[t].value = zero;
+        slots[t].level.store(0, std::memory_order_relaxed);
+    }
 
-    constexpr std::size_t k = 2;
+    // The hand-rolled Mt/mt arithmetic that used to live here computed wrong
+    // block bounds (k % T for K % T, it1 * mt for it1 + mt) and silently
+    // reduced the wrong subranges; split_range is the verified split.
     auto thread_proc = [=] (unsigned t) {
-        auto K = ceil_div(n, k);
-        std::size_t Mt = K/T, it1 = k % T;
-        if (t < it1) {
-           it1 = ++Mt * t;
-        } else {
-           it1 = Mt * it1 + t;
-        }
-        it1 *= k;
-        std::size_t mt = Mt * k;
-        auto it2 = it1 * mt;
+        auto [lo, hi] = split_range(n, T, t);
         ElementType accum = zero;
 
-        for (std::size_t i = it1; i < it2; ++i) {
+        for (std::size_t i = lo; i < hi; ++i) {
             accum = f(accum, V[i]);
         }
 
-        reduction_partial_results[t].value = accum;
+        slots[t].value = accum;
+        tree_combine(slots, T, t, f);
     };
 
-//    auto thread_proc_2 = [=] (unsigned t) {
-//        constexpr std::size_t k = 2;
-//        std::size_t s = 1;
-//
-//        while((t % (s * k)) == 0 && s + t < T) {
-//            reduction_partial_results[T].value = f(reduction_partial_results[t].value, reduction_partial_results[t + s].value);
-//            s *= k;
-//        }
-//    };
-
-    auto thread_proc_2_ = [=] (unsigned t, std::size_t s) {
-        if(((t % (s * k)) == 0) && (t + s < T))
-            reduction_partial_results[t].value = f(reduction_partial_results[t].value,
-                                                   reduction_partial_results[t + s].value);
-    };
+    run_on_pool(T, thread_proc);
+
+    return slots[0].value;
+}
 
-    std::vector<std::thread> threads;
-    for(unsigned t = 1; t < T; t++) {
-        threads.emplace_back(thread_proc, t);
+// Streaming variant of reduce_vector for DRAM-resident data. Two things
+// change in the inner loop: eight independent accumulator chains, because a
+// single accum = f(accum, V[i]) serializes on the FP adder and caps the
+// loop at add-latency speed rather than bandwidth; and explicit software
+// prefetch prefetch_lines cache lines ahead, so the demand stream never
+// waits on DRAM latency. nt = true issues the prefetch with the
+// non-temporal hint — the data bypasses the higher cache levels, which is
+// what you want for a single pass over an array far beyond LLC.
+// Chain order changes the FP rounding versus reduce_vector by design.
+template <class ElementType, class BinaryFn>
+ElementType reduce_vector_stream(const ElementType* V, std::size_t n, BinaryFn f, ElementType zero,
+                                 std::size_t prefetch_lines = 8, bool nt = false) {
+    unsigned T = get_num_threads();
+    auto slots = static_cast<combine_slot<ElementType>*>(
+            reduction_scratch(T * sizeof(combine_slot<ElementType>)));
+    for (unsigned t = 0; t < T; ++t) {
+        slots[t].value = zero;
+        slots[t].level.store(0, std::memory_order_relaxed);
     }
 
-    thread_proc(0);
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        constexpr std::size_t line = hardware_destructive_interference_size / sizeof(ElementType);
+        const std::size_t dist = prefetch_lines * (line ? line : 1);
 
-    for(auto& thread:threads) {
-        thread.join();
-    }
+        ElementType c0 = zero, c1 = zero, c2 = zero, c3 = zero;
+        ElementType c4 = zero, c5 = zero, c6 = zero, c7 = zero;
+        std::size_t i = lo;
+        for (; i + 8 <= hi; i += 8) {
+            if (i + dist < hi) {
+                if (nt)
+                    __builtin_prefetch(V + i + dist, 0, 0);
+                else
+                    __builtin_prefetch(V + i + dist, 0, 3);
+            }
+            c0 = f(c0, V[i]);
+            c1 = f(c1, V[i + 1]);
+            c2 = f(c2, V[i + 2]);
+            c3 = f(c3, V[i + 3]);
+            c4 = f(c4, V[i + 4]);
+            c5 = f(c5, V[i + 5]);
+            c6 = f(c6, V[i + 6]);
+            c7 = f(c7, V[i + 7]);
+        }
+        ElementType accum = f(f(f(c0, c1), f(c2, c3)), f(f(c4, c5), f(c6, c7)));
+        for (; i < hi; ++i)
+            accum = f(accum, V[i]);
+
+        slots[t].value = accum;
+        tree_combine(slots, T, t, f);
+    });
 
-    std::size_t s = 1;
-    while(s < T) {
-        for(unsigned t = 1; t < T; ++t) {
-            threads[t - 1] = std::thread(thread_proc_2_, t, s);
+    return slots[0].value;
+}
+
+// Applies fn to every element of V in place, one contiguous block per thread
+// so no two threads write the same cache line. The write-side counterpart of
+// reduce_vector for element-wise passes that used to be hand-rolled
+// #pragma omp parallel blocks.
+template <class ElementType, class UnaryFn>
+void map_vector(ElementType* V, std::size_t n, UnaryFn fn) {
+    unsigned T = get_num_threads();
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        for (std::size_t i = lo; i < hi; ++i)
+            V[i] = fn(V[i]);
+    });
+}
+
+// Out-of-place form: out[i] = fn(in[i]). in and out must not overlap.
+template <class ElementType, class UnaryFn>
+void transform(const ElementType* in, ElementType* out, std::size_t n, UnaryFn fn) {
+    unsigned T = get_num_threads();
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        for (std::size_t i = lo; i < hi; ++i)
+            out[i] = fn(in[i]);
+    });
+}
+
+// Atomic work distributor for irregular workloads: threads grab the next
+// chunk of [0, n) instead of owning a fixed block, so nobody waits on the
+// slowest thread at the join. Chunks are multiples of min_chunk (pick a
+// cache-line multiple); in guided mode the chunk shrinks with the remaining
+// work — big chunks early for low overhead, small ones late for balance.
+class dynamic_ranges {
+    std::atomic<std::size_t> next{0};
+    std::size_t n;
+    std::size_t min_chunk;
+    std::size_t guided_div;   // 0 = fixed chunks
+
+public:
+    dynamic_ranges(std::size_t n, std::size_t min_chunk, unsigned T, bool guided = false)
+        : n(n), min_chunk(min_chunk), guided_div(guided ? 2 * (std::size_t) T : 0) {}
+
+    bool grab(std::size_t &lo, std::size_t &hi) {
+        std::size_t i = next.load(std::memory_order_relaxed);
+        for (;;) {
+            if (i >= n)
+                return false;
+            std::size_t c = min_chunk;
+            if (guided_div) {
+                c = (n - i) / guided_div;
+                c = c < min_chunk ? min_chunk : c / min_chunk * min_chunk;
+            }
+            if (next.compare_exchange_weak(i, i + c, std::memory_order_relaxed)) {
+                lo = i;
+                hi = i + c < n ? i + c : n;
+                return true;
+            }
         }
-        thread_proc_2_(0, s);
-        s *= k;
+    }
+};
 
-        for(auto& thread:threads) {
-            thread.join();
+// reduce_range with dynamic scheduling: same get/reduce_2 split and aligned
+// partials, but iteration chunks come from a dynamic_ranges distributor so
+// skewed integrands no longer leave threads idle at the end.
+template <class ElementType, class UnaryFn, class BinaryFn>
+ElementType reduce_range_dynamic(ElementType a, ElementType b, std::size_t n, UnaryFn get,
+                                 BinaryFn reduce_2, ElementType zero,
+                                 std::size_t chunk = 1024, bool guided = true) {
+    unsigned T = get_num_threads();
+    auto reduction_partial_results = static_cast<padded_accumulator<ElementType>*>(
+            reduction_scratch(T * sizeof(padded_accumulator<ElementType>)));
+    double dx = (b - a) / n;
+    dynamic_ranges ranges{n, chunk, T, guided};
+
+    run_on_pool(T, [=, &ranges](unsigned t) {
+        ElementType accum = zero;
+        std::size_t lo, hi;
+        while (ranges.grab(lo, hi))
+            for (std::size_t i = lo; i < hi; ++i)
+                accum = reduce_2(accum, get(a + i * dx));
+        reduction_partial_results[t].value = accum;
+    });
+
+    ElementType result = zero;
+    for (unsigned t = 0; t < T; ++t)
+        result = reduce_2(result, reduction_partial_results[t].value);
+    return result;
+}
+
+// 2D midpoint-rule integration in a single parallel region. The grid is cut
+// into tile x tile blocks and the whole tile list is split across the pool
+// once — no serial outer loop re-dispatching the pool per y row, which paid
+// start/join and combine setup ny times. Tiles keep each thread's working
+// set of samples cache-sized, and the per-thread partials merge through the
+// same barrier-free tree combine as the 1D reductions.
+template <class BinaryFn2D>
+double integrate2d(double ax, double bx, double ay, double by,
+                   std::size_t nx, std::size_t ny, BinaryFn2D f,
+                   std::size_t tile = 128) {
+    unsigned T = get_num_threads();
+    auto slots = static_cast<combine_slot<double>*>(
+            reduction_scratch(T * sizeof(combine_slot<double>)));
+    for (unsigned t = 0; t < T; ++t) {
+        slots[t].value = 0;
+        slots[t].level.store(0, std::memory_order_relaxed);
+    }
+
+    double dx = (bx - ax) / nx, dy = (by - ay) / ny;
+    std::size_t tiles_x = ceil_div(nx, tile);
+    std::size_t n_tiles = tiles_x * ceil_div(ny, tile);
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n_tiles, T, t);
+        double accum = 0;
+        for (std::size_t k = lo; k < hi; ++k) {
+            std::size_t x0 = (k % tiles_x) * tile;
+            std::size_t y0 = (k / tiles_x) * tile;
+            std::size_t x1 = x0 + tile < nx ? x0 + tile : nx;
+            std::size_t y1 = y0 + tile < ny ? y0 + tile : ny;
+            for (std::size_t j = y0; j < y1; ++j) {
+                double y = ay + j * dy;
+                double row = 0;
+                for (std::size_t i = x0; i < x1; ++i)
+                    row += f(ax + i * dx, y);
+                accum += row;
+            }
         }
+        slots[t].value = accum;
+        tree_combine(slots, T, t, [](double a, double b) { return a + b; });
+    });
+
+    return slots[0].value * dx * dy;
+}
+
+// Adaptive Simpson step: the interval's error estimate is the Richardson
+// difference between one Simpson panel over [a, b] and the two panels over
+// its halves. Intervals outside tolerance split in two; the left half goes
+// onto the work-stealing deques as a task while this thread descends right,
+// so the subinterval queue balances itself across the pool. spawn_depth
+// bounds task creation — below it the recursion runs serially, the same
+// cutoff idea FibonacciNew uses.
+template <class UnaryFn>
+double integrate_adaptive_step(double a, double b, double fa, double fm, double fb,
+                               double whole, UnaryFn f, double tol, int spawn_depth) {
+    double m = 0.5 * (a + b);
+    double lm = 0.5 * (a + m), rm = 0.5 * (m + b);
+    double flm = f(lm), frm = f(rm);
+    double left = (m - a) / 6 * (fa + 4 * flm + fm);
+    double right = (b - m) / 6 * (fm + 4 * frm + fb);
+    double err = (left + right - whole) / 15;
+
+    if (std::abs(err) <= tol)
+        return left + right + err;
+
+    if (spawn_depth > 0) {
+        double x1;
+        task_group g;
+        g.spawn([&x1, a, m, fa, flm, fm, left, f, tol, spawn_depth] {
+            x1 = integrate_adaptive_step(a, m, fa, flm, fm, left, f, tol / 2, spawn_depth - 1);
+        });
+        double x2 = integrate_adaptive_step(m, b, fm, frm, fb, right, f, tol / 2, spawn_depth - 1);
+        g.sync();
+        return x1 + x2;
+    }
+
+    return integrate_adaptive_step(a, m, fa, flm, fm, left, f, tol / 2, 0)
+         + integrate_adaptive_step(m, b, fm, frm, fb, right, f, tol / 2, 0);
+}
+
+// Error-driven quadrature: refines only where the integrand demands it, so a
+// smooth region costs a handful of evaluations while a sharp feature gets as
+// many as the tolerance requires — no STEPS knob to guess. tol is the
+// absolute error target for the whole of [a, b].
+template <class UnaryFn>
+double integrate_adaptive(double a, double b, UnaryFn f, double tol = 1e-9) {
+    double fa = f(a), fb = f(b), fm = f(0.5 * (a + b));
+    double whole = (b - a) / 6 * (fa + 4 * fm + fb);
+
+    // Enough spawn levels for ~8 steal-able subtrees per thread; deeper
+    // intervals refine serially to keep task overhead off the leaves.
+    unsigned T = get_num_threads();
+    int spawn_depth = 3;
+    while ((1u << spawn_depth) < 8 * T)
+        ++spawn_depth;
+
+    return integrate_adaptive_step(a, b, fa, fm, fb, whole, f, tol, spawn_depth);
+}
+
+// Kahan-compensated accumulator: carries the rounding error of every add in
+// a compensation term, so summing 1e8 doubles no longer loses low bits to
+// the order of accumulation. Both members stay in registers in the hot loop.
+template <class ElementType>
+struct kahan_accumulator {
+    ElementType sum, c;
+
+    void add(ElementType x) {
+        ElementType y = x - c;
+        ElementType t = sum + y;
+        c = (t - sum) - y;
+        sum = t;
+    }
+};
+
+// Compensated counterpart of reduce_vector, addition only — compensation has
+// no meaning for an arbitrary reduce_2. One Kahan accumulator per thread,
+// partials combined with Kahan as well, so the result stops drifting in the
+// last digits as the thread count changes.
+template <class ElementType>
+ElementType reduce_vector_kahan(const ElementType* V, std::size_t n, ElementType zero) {
+    unsigned T = get_num_threads();
+    auto reduction_partial_results = static_cast<padded_accumulator<ElementType>*>(
+            reduction_scratch(T * sizeof(padded_accumulator<ElementType>)));
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        kahan_accumulator<ElementType> accum{zero, zero};
+        for (std::size_t i = lo; i < hi; ++i)
+            accum.add(V[i]);
+        reduction_partial_results[t].value = accum.sum;
+    });
+
+    kahan_accumulator<ElementType> total{zero, zero};
+    for (unsigned t = 0; t < T; ++t)
+        total.add(reduction_partial_results[t].value);
+    return total.sum;
+}
+
+// Compensated counterpart of reduce_range for sums of get(x) over a uniform
+// grid; same blocked split, Kahan per thread and across partials.
+template <class ElementType, class UnaryFn>
+ElementType reduce_range_kahan(ElementType a, ElementType b, std::size_t n, UnaryFn get, ElementType zero) {
+    unsigned T = get_num_threads();
+    auto reduction_partial_results = static_cast<padded_accumulator<ElementType>*>(
+            reduction_scratch(T * sizeof(padded_accumulator<ElementType>)));
+    double dx = (b - a) / n;
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        kahan_accumulator<ElementType> accum{zero, zero};
+        for (std::size_t i = lo; i < hi; ++i)
+            accum.add(get(a + i * dx));
+        reduction_partial_results[t].value = accum.sum;
+    });
+
+    kahan_accumulator<ElementType> total{zero, zero};
+    for (unsigned t = 0; t < T; ++t)
+        total.add(reduction_partial_results[t].value);
+    return total.sum;
+}
+
+// Inclusive in-place prefix scan: V[i] becomes f(V[0], ..., V[i]).
+// Up-sweep: every thread reduces its contiguous block into an aligned
+// partial. The T block totals get a serial exclusive scan (O(T), invisible
+// next to the two n-sized passes) giving each block its starting offset.
+// Down-sweep: every thread rescans its block seeded with that offset.
+template <class ElementType, class BinaryFn>
+void scan_vector(ElementType* V, std::size_t n, BinaryFn f, ElementType zero) {
+    unsigned T = get_num_threads();
+    auto partials = static_cast<padded_accumulator<ElementType>*>(
+            reduction_scratch(T * sizeof(padded_accumulator<ElementType>)));
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        ElementType accum = zero;
+        for (std::size_t i = lo; i < hi; ++i)
+            accum = f(accum, V[i]);
+        partials[t].value = accum;
+    });
+
+    ElementType running = zero;
+    for (unsigned t = 0; t < T; ++t) {
+        ElementType next = f(running, partials[t].value);
+        partials[t].value = running;
+        running = next;
     }
 
-//    for(unsigned t = 1; t < T; t++) {
-//        threads[t-1] = std::thread(thread_proc_2, t);
-//    }
-//
-//    thread_proc_2(0);
-//
-//    for(auto& thread:threads) {
-//        thread.join();
-//    }
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        ElementType accum = partials[t].value;
+        for (std::size_t i = lo; i < hi; ++i) {
+            accum = f(accum, V[i]);
+            V[i] = accum;
+        }
+    });
+}
+
+// Fused map+reduce: folds fn(V[i]) into the accumulator in a single pass, so
+// "reduce of a transformed array" costs one memory sweep instead of a fill
+// pass plus a read pass. Same get/reduce_2 split as reduce_range.
+template <class ElementType, class UnaryFn, class BinaryFn>
+ElementType transform_reduce(const ElementType* V, std::size_t n, UnaryFn fn, BinaryFn reduce_2, ElementType zero) {
+    unsigned T = get_num_threads();
+    auto reduction_partial_results = static_cast<padded_accumulator<ElementType>*>(
+            reduction_scratch(T * sizeof(padded_accumulator<ElementType>)));
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(n, T, t);
+        ElementType accum = zero;
+        for (std::size_t i = lo; i < hi; ++i)
+            accum = reduce_2(accum, fn(V[i]));
+        reduction_partial_results[t].value = accum;
+    });
 
-    return reduction_partial_results[0].value;
+    ElementType result = zero;
+    for (unsigned t = 0; t < T; ++t)
+        result = reduce_2(result, reduction_partial_results[t].value);
+    return result;
 }
 
 template <class ElementType, class UnaryFn, class BinaryFn>
@@ -109,57 +480,31 @@ requires (
 )
 ElementType reduce_range(ElementType a, ElementType b, std::size_t n, UnaryFn get, BinaryFn reduce_2, ElementType zero) {
     unsigned T = get_num_threads();
-    struct reduction_partial_result_t
-    {
-        alignas(hardware_destructive_interference_size) ElementType value;
-    };
-    static auto reduction_partial_results =
-            std::vector<reduction_partial_result_t>(std::thread::hardware_concurrency(), reduction_partial_result_t{zero});
+    auto slots = static_cast<combine_slot<ElementType>*>(
+            reduction_scratch(T * sizeof(combine_slot<ElementType>)));
+    for (unsigned t = 0; t < T; ++t) {
+        slots[t].value = zero;
+        slots[t].level.store(0, std::memory_order_relaxed);
+    }
 
-    std::barrier<> bar{T};
-    constexpr std::size_t k = 2;
-    auto thread_proc = [=, &bar](unsigned t)
+    auto thread_proc = [=](unsigned t)
     {
-
-        auto K = ceil_div(n, k);
+        PROF_START(t);
         double dx = (b - a) / n;
-        std::size_t Mt = K / T;
-        std::size_t it1 = K % T;
-
-        if(t < it1)
-        {
-            it1 = ++Mt * t;
-        }
-        else
-        {
-            it1 = Mt * t + it1;
-        }
-        it1 *= k;
-        std::size_t mt = Mt * k;
-        std::size_t it2 = it1 + mt;
+        auto [lo, hi] = split_range(n, T, t);
 
         ElementType accum = zero;
-        for(std::size_t i = it1; i < it2; i++)
+        for(std::size_t i = lo; i < hi; i++)
             accum = reduce_2(accum, get(a + i*dx));
 
-        reduction_partial_results[t].value = accum;
+        slots[t].value = accum;
+        PROF_PHASE(t, prof_compute);
 
-        for(std::size_t s = 1, s_next = 2; s < T; s = s_next, s_next += s_next)
-        {
-            bar.arrive_and_wait();
-            if(((t % s_next) == 0) && (t + s < T))
-                reduction_partial_results[t].value = reduce_2(reduction_partial_results[t].value,
-                                                              reduction_partial_results[t + s].value);
-        }
+        tree_combine(slots, T, t, reduce_2);
     };
 
-    std::vector<std::thread> threads;
-    for(unsigned t = 1; t < T; t++)
-        threads.emplace_back(thread_proc, t);
-    thread_proc(0);
-    for(auto& thread : threads)
-        thread.join();
-    return reduction_partial_results[0].value;
+    run_on_pool(T, thread_proc);
+    return slots[0].value;
 }
 
 int reduction() {
@@ -168,6 +513,8 @@ int reduction() {
         V[i] = i + 1;
     }
 
-    std::cout << "Average: " << reduce_vector(V, 16, [](auto x, auto y) { return x + y;}, 0u) / std::size(V) << "\n";
+    std::cout << "Average: " << reduce_vector(V, std::size(V), [](auto x, auto y) { return x + y;}, 0u) / std::size(V) << "\n";
     return 0;
-}
\ No newline at end of file
+}
+
+#endif //PARALLEL_REDUCTION_CPP
@@ -0,0 +1,98 @@
+#ifndef PARALLEL_STREAM_REDUCE_H
+#define PARALLEL_STREAM_REDUCE_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+#include "accumulators.h"
+#include "reduction.cpp"
+
+// Streaming front end for files larger than memory: the file is read in
+// large aligned chunks into two buffers, and while the pool reduces chunk i
+// a dedicated reader thread fills the other buffer with chunk i+1 — so the
+// pipeline sustains device bandwidth instead of alternating idle-CPU and
+// idle-disk phases. One reader is enough: a single sequential stream already
+// saturates the device, and the pool owns every core for the reduce.
+//
+// Chunk results fold with the same reduce_2 the in-memory kernels take, so
+// reduce_2 must be associative across chunk boundaries (sums, min/max — the
+// usual reductions). The file size must be a multiple of
+// sizeof(ElementType). Returns zero on open/read failure, with a message on
+// stderr, matching how the drivers report rather than throw.
+#ifdef __linux__
+template <class ElementType, class BinaryFn>
+ElementType reduce_file(const char* path, BinaryFn reduce_2, ElementType zero,
+                        std::size_t chunk_bytes = 1u << 24) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return zero;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    std::size_t total = (std::size_t) st.st_size - (std::size_t) st.st_size % sizeof(ElementType);
+
+    // Page-aligned buffers so the kernel can DMA straight into them.
+    chunk_bytes -= chunk_bytes % sizeof(ElementType);
+    auto* buf0 = (char*) std::aligned_alloc(4096, chunk_bytes);
+    auto* buf1 = (char*) std::aligned_alloc(4096, chunk_bytes);
+    char* bufs[2] = {buf0, buf1};
+
+    // Short reads only happen at EOF for regular files, but loop anyway.
+    auto read_chunk = [&](char* dst, std::size_t off) -> std::size_t {
+        std::size_t want = total - off < chunk_bytes ? total - off : chunk_bytes;
+        std::size_t got = 0;
+        while (got < want) {
+            ssize_t r = pread(fd, dst + got, want - got, (off_t) (off + got));
+            if (r <= 0) {
+                if (r < 0)
+                    perror(path);
+                break;
+            }
+            got += (std::size_t) r;
+        }
+        return got;
+    };
+
+    ElementType result = zero;
+    std::size_t filled = read_chunk(bufs[0], 0);
+    std::size_t off = 0;
+    unsigned cur = 0;
+
+    while (filled) {
+        // Kick off the read of the next chunk before touching this one.
+        std::size_t next_off = off + filled;
+        std::size_t next_filled = 0;
+        std::thread reader;
+        if (next_off < total)
+            reader = std::thread([&, next_off] {
+                next_filled = read_chunk(bufs[cur ^ 1], next_off);
+            });
+
+        auto* V = (const ElementType*) bufs[cur];
+        ElementType chunk_result = transform_reduce(
+                V, filled / sizeof(ElementType),
+                [](ElementType x) { return x; }, reduce_2, zero);
+        result = reduce_2(result, chunk_result);
+
+        if (reader.joinable())
+            reader.join();
+        off = next_off;
+        filled = next_filled;
+        cur ^= 1;
+    }
+
+    std::free(buf0);
+    std::free(buf1);
+    close(fd);
+    return result;
+}
+#endif //__linux__
+
+#endif //PARALLEL_STREAM_REDUCE_H
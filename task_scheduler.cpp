@@ -0,0 +1,123 @@
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include "task_scheduler.h"
+#include "threads.h"
+
+namespace {
+
+struct worker_deque {
+    std::mutex mtx;
+    std::deque<std::function<void()>> q;
+};
+
+class work_stealing_scheduler {
+    std::vector<std::unique_ptr<worker_deque>> deques;
+    std::vector<std::thread> workers;
+    std::mutex cv_mtx;
+    std::condition_variable cv;
+    std::atomic<std::size_t> task_count{0};
+    std::atomic<bool> stop{false};
+
+    static thread_local unsigned my_id;
+
+    void worker(unsigned id) {
+        my_id = id;
+        for (;;) {
+            if (stop.load(std::memory_order_relaxed))
+                return;
+            // Workers beyond the current get_num_threads() limit stay idle so
+            // the experiment sweeps still control effective parallelism.
+            if (id < get_num_threads() && try_run_one())
+                continue;
+            std::unique_lock lck{cv_mtx};
+            cv.wait_for(lck, std::chrono::microseconds(50),
+                        [&] { return stop.load() || task_count.load() > 0; });
+        }
+    }
+
+public:
+    work_stealing_scheduler() {
+        unsigned n = std::thread::hardware_concurrency();
+        for (unsigned t = 0; t < n; ++t)
+            deques.emplace_back(std::make_unique<worker_deque>());
+        for (unsigned t = 1; t < n; ++t)
+            workers.emplace_back(&work_stealing_scheduler::worker, this, t);
+    }
+
+    ~work_stealing_scheduler() {
+        stop = true;
+        cv.notify_all();
+        for (auto &w: workers)
+            w.join();
+    }
+
+    void push(std::function<void()> fn) {
+        auto &d = *deques[my_id];
+        {
+            std::scoped_lock lck{d.mtx};
+            d.q.emplace_back(std::move(fn));
+        }
+        ++task_count;
+        cv.notify_one();
+    }
+
+    bool try_run_one() {
+        std::function<void()> fn;
+        auto &own = *deques[my_id];
+        {
+            std::scoped_lock lck{own.mtx};
+            if (!own.q.empty()) {
+                fn = std::move(own.q.back());
+                own.q.pop_back();
+            }
+        }
+        if (!fn) {
+            for (std::size_t i = 1; i < deques.size() && !fn; ++i) {
+                auto &victim = *deques[(my_id + i) % deques.size()];
+                std::scoped_lock lck{victim.mtx};
+                if (!victim.q.empty()) {
+                    fn = std::move(victim.q.front());
+                    victim.q.pop_front();
+                }
+            }
+        }
+        if (!fn)
+            return false;
+        --task_count;
+        fn();
+        return true;
+    }
+};
+
+thread_local unsigned work_stealing_scheduler::my_id = 0;
+
+work_stealing_scheduler &scheduler() {
+    static work_stealing_scheduler s;
+    return s;
+}
+
+}
+
+bool scheduler_try_run_one() {
+    return scheduler().try_run_one();
+}
+
+void task_group::spawn(std::function<void()> fn) {
+    ++pending;
+    scheduler().push([this, fn = std::move(fn)] {
+        fn();
+        --pending;
+    });
+}
+
+void task_group::sync() {
+    while (pending.load(std::memory_order_acquire) != 0) {
+        if (!scheduler_try_run_one())
+            std::this_thread::yield();
+    }
+}
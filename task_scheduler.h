@@ -0,0 +1,31 @@
+#ifndef PARALLEL_TASK_SCHEDULER_H
+#define PARALLEL_TASK_SCHEDULER_H
+
+#include <functional>
+#include <atomic>
+
+// Work-stealing scheduler for recursive divide-and-conquer workloads.
+// Every worker owns a deque: it pushes and pops spawned tasks at the back
+// (LIFO, keeps the working set hot) while idle workers steal from the front
+// of someone else's deque (FIFO, takes the biggest subtree). Callers group
+// child tasks in a task_group and sync() on it; while waiting, the caller
+// executes pending tasks itself instead of blocking.
+//
+// Usage:
+//     task_group g;
+//     g.spawn([&] { left = solve(n - 1); });
+//     right = solve(n - 2);
+//     g.sync();
+
+bool scheduler_try_run_one();
+
+class task_group {
+    std::atomic<unsigned> pending{0};
+
+public:
+    void spawn(std::function<void()> fn);
+
+    void sync();
+};
+
+#endif //PARALLEL_TASK_SCHEDULER_H
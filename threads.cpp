@@ -1,7 +1,111 @@
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 #include "omp.h"
+#include "threads.h"
 
 static unsigned g_num_thread = std::thread::hardware_concurrency();
+static std::atomic<bool> g_pin_threads{false};
+
+// Pins the calling thread to the given CPU (mod hardware_concurrency).
+// No-op off Linux.
+static void pin_to_cpu(unsigned cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % std::thread::hardware_concurrency(), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) cpu;
+#endif
+}
+
+// Pool workers pin one-to-one only while pinning is enabled.
+static void pin_self(unsigned t) {
+    if (g_pin_threads.load(std::memory_order_relaxed))
+        pin_to_cpu(t);
+}
+
+namespace {
+
+// Process-lifetime pool. Workers sleep on a condition variable between jobs;
+// a job is published by bumping the generation counter. The caller acts as
+// worker 0 itself, so T=1 never touches the pool at all.
+class thread_pool {
+    std::vector<std::thread> workers;
+    std::mutex mtx;
+    std::condition_variable work_cv, done_cv;
+    const std::function<void(unsigned)> *body = nullptr;
+    unsigned active = 0;
+    unsigned remaining = 0;
+    uint64_t generation = 0;
+    bool stop = false;
+
+    void worker(unsigned t, uint64_t last_gen) {
+        std::unique_lock lck{mtx};
+        for (;;) {
+            work_cv.wait(lck, [&] { return stop || generation != last_gen; });
+            if (stop)
+                return;
+            last_gen = generation;
+            if (t < active) {
+                auto fn = body;
+                lck.unlock();
+                pin_self(t);
+                (*fn)(t);
+                lck.lock();
+                if (--remaining == 0)
+                    done_cv.notify_one();
+            }
+        }
+    }
+
+public:
+    ~thread_pool() {
+        {
+            std::scoped_lock lck{mtx};
+            stop = true;
+        }
+        work_cv.notify_all();
+        for (auto &w: workers)
+            w.join();
+    }
+
+    void run(unsigned T, const std::function<void(unsigned)> &fn) {
+        if (T <= 1) {
+            fn(0);
+            return;
+        }
+        {
+            std::scoped_lock lck{mtx};
+            for (auto t = (unsigned) workers.size() + 1; t < T; ++t)
+                workers.emplace_back(&thread_pool::worker, this, t, generation);
+            body = &fn;
+            active = T;
+            remaining = T - 1;
+            ++generation;
+        }
+        work_cv.notify_all();
+        fn(0);
+        std::unique_lock lck{mtx};
+        done_cv.wait(lck, [&] { return remaining == 0; });
+    }
+};
+
+thread_pool &pool() {
+    static thread_pool p;
+    return p;
+}
+
+}
 
 void set_num_threads(unsigned T) {
     g_num_thread = T;
@@ -12,3 +116,66 @@ unsigned get_num_threads() {
     return g_num_thread;
 }
 
+void run_on_pool(unsigned T, const std::function<void(unsigned)> &body) {
+    pool().run(T, body);
+}
+
+std::future<void> run_on_cores_async(core_set cs, std::function<void(unsigned)> body) {
+    auto done = std::make_shared<std::promise<void>>();
+    auto fut = done->get_future();
+    if (cs.count == 0) {
+        done->set_value();
+        return fut;
+    }
+
+    // Shared state keeps the team alive past this call; the last worker out
+    // fulfils the promise, so fut.wait() means every body(t) has returned.
+    auto fn = std::make_shared<std::function<void(unsigned)>>(std::move(body));
+    auto remaining = std::make_shared<std::atomic<unsigned>>(cs.count);
+
+    for (unsigned t = 0; t < cs.count; ++t)
+        std::thread([=, first = cs.first] {
+            pin_to_cpu(first + t);
+            (*fn)(t);
+            if (remaining->fetch_sub(1) == 1)
+                done->set_value();
+        }).detach();
+
+    return fut;
+}
+
+void pin_threads(bool enable) {
+    g_pin_threads = enable;
+    if (enable)
+        pin_self(0);
+}
+
+unsigned get_thread_numa_node(unsigned t) {
+#ifdef __linux__
+    char path[128];
+    unsigned cpu = t % std::thread::hardware_concurrency();
+    snprintf(path, sizeof(path),
+             "/sys/devices/system/cpu/cpu%u/topology/physical_package_id", cpu);
+    if (FILE *f = fopen(path, "r")) {
+        unsigned node = 0;
+        if (fscanf(f, "%u", &node) != 1)
+            node = 0;
+        fclose(f);
+        return node;
+    }
+#endif
+    (void) t;
+    return 0;
+}
+
+void first_touch(void *buf, std::size_t bytes) {
+    unsigned T = get_num_threads();
+    auto p = static_cast<char *>(buf);
+    constexpr std::size_t page = 4096;
+
+    run_on_pool(T, [=](unsigned t) {
+        auto [lo, hi] = split_range(bytes, T, t);
+        for (std::size_t i = lo; i < hi; i += page)
+            p[i] = 0;
+    });
+}
@@ -0,0 +1,61 @@
+#ifndef PARALLEL_THREADS_H
+#define PARALLEL_THREADS_H
+
+#include <functional>
+#include <future>
+#include <cstddef>
+
+// Contiguous [begin, end) block for thread t of T over n items: the first
+// n % T threads take one extra element. The single definition of the block
+// split — reduce_vector's hand-rolled copy of this arithmetic was wrong in
+// two places and reduced the wrong subranges. constexpr so it folds to
+// constants whenever n, T and t are known at compile time.
+struct index_range {
+    std::size_t begin, end;
+};
+
+constexpr index_range split_range(std::size_t n, unsigned T, unsigned t) {
+    std::size_t q = n / T, r = n % T;
+    std::size_t begin = t * q + (t < r ? t : r);
+    return {begin, begin + q + (t < r ? 1 : 0)};
+}
+
+unsigned get_num_threads();
+
+void set_num_threads(unsigned T);
+
+// Pins pool worker t (and the calling thread, which acts as worker 0)
+// one-to-one onto CPU t. Without pinning the scheduler migrates workers
+// between sockets, and pages first-touched on one socket get read remotely.
+void pin_threads(bool enable);
+
+// NUMA node of the CPU worker t lands on. Read from sysfs (the physical
+// package id, which matches the node on our machines); 0 when the topology
+// is not exposed.
+unsigned get_thread_numa_node(unsigned t);
+
+// Parallel first-touch: worker t faults in its contiguous share of buf, so
+// with pinning enabled each thread's partition lives in local DRAM instead
+// of on whichever node called the allocator. Call before the timed region.
+void first_touch(void *buf, std::size_t bytes);
+
+// A contiguous span of CPUs [first, first + count). Two kernels launched on
+// disjoint core sets never oversubscribe each other.
+struct core_set {
+    unsigned first, count;
+};
+
+// Asynchronous launch: runs body(t) for t in [0, cs.count) with each worker
+// pinned to CPU cs.first + t — unconditionally, not gated on pin_threads,
+// because placement is the whole point of a core set. Returns a future that
+// becomes ready once every worker has finished. Workers are fresh threads
+// rather than pool workers: the pool runs one job at a time, and this
+// surface exists to run several side by side.
+std::future<void> run_on_cores_async(core_set cs, std::function<void(unsigned)> body);
+
+// Runs body(t) for every t in [0, T) on a process-lifetime worker pool and
+// waits until all of them finish. Workers are spawned once and reused, so
+// repeated kernel invocations pay no thread-creation cost.
+void run_on_pool(unsigned T, const std::function<void(unsigned)> &body);
+
+#endif //PARALLEL_THREADS_H
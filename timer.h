@@ -0,0 +1,92 @@
+#ifndef PARALLEL_TIMER_H
+#define PARALLEL_TIMER_H
+
+// Timing source for the experiment drivers, replacing omp_get_wtime: its
+// ~1µs resolution is useless in the short-kernel regime the granularity and
+// contention benchmarks probe, and it tied kernels that never touch OpenMP
+// to the OpenMP runtime. On x86 the source is rdtscp — serialized, so it
+// does not read before earlier instructions retire — with the tick period
+// calibrated once against steady_clock; elsewhere steady_clock is the
+// source. timer_overhead() self-measures the cost of a timestamp pair so
+// drivers subtract it from short runs via timer_elapsed.
+
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+
+inline uint64_t timer_ticks() {
+    unsigned aux;
+    return __rdtscp(&aux);
+}
+
+// Seconds per tick, calibrated once: count ticks across a ~10ms
+// steady_clock window. The invariant TSC rate is stable, so one calibration
+// holds for the process lifetime.
+inline double timer_tick_period() {
+    static const double period = [] {
+        auto c0 = std::chrono::steady_clock::now();
+        uint64_t t0 = timer_ticks();
+        while (std::chrono::steady_clock::now() - c0 < std::chrono::milliseconds(10))
+            ;
+        uint64_t t1 = timer_ticks();
+        auto c1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(c1 - c0).count() / (double) (t1 - t0);
+    }();
+    return period;
+}
+
+#else
+
+inline uint64_t timer_ticks() {
+    return (uint64_t) std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+inline double timer_tick_period() {
+    return (double) std::chrono::steady_clock::period::num
+         / (double) std::chrono::steady_clock::period::den;
+}
+
+#endif
+
+inline double timer_seconds() {
+    // Read the period first: evaluation order in a single expression is
+    // unspecified, and taking the timestamp before a lazy first calibration
+    // would put the whole 10ms window inside the caller's timed region.
+    double period = timer_tick_period();
+    return (double) timer_ticks() * period;
+}
+
+// Median cost of one back-to-back timestamp pair, measured once. This is
+// what a timed region of zero work would report, so subtracting it makes
+// nanosecond-scale measurements mean what they say.
+inline double timer_overhead() {
+    static const double overhead = [] {
+        constexpr int samples = 1001;
+        double d[samples];
+        for (int i = 0; i < samples; ++i) {
+            double t0 = timer_seconds();
+            double t1 = timer_seconds();
+            d[i] = t1 - t0;
+        }
+        std::sort(d, d + samples);
+        return d[samples / 2];
+    }();
+    return overhead;
+}
+
+// Forces both lazy blocks — the 10ms calibration and the 1001-pair overhead
+// measurement — during static initialization, before main runs, so the first
+// timed region in a process measures its own work and nothing else.
+inline const double timer_calibration_ = (timer_tick_period(), timer_overhead());
+
+// Elapsed seconds between two timer_seconds() readings with the measurement
+// cost removed, clamped at zero for runs shorter than the overhead itself.
+inline double timer_elapsed(double t0, double t1) {
+    double dt = t1 - t0 - timer_overhead();
+    return dt > 0 ? dt : 0;
+}
+
+#endif //PARALLEL_TIMER_H